@@ -0,0 +1,291 @@
+#ifndef CONCURRENT_HASH_MAP_H
+#define CONCURRENT_HASH_MAP_H
+
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "hash_map_SOLID.hpp"
+
+namespace hash_map_impl {
+
+    inline constexpr std::size_t cache_line_size = 64;
+
+    // One independently locked partition. The shard hashes each key once for
+    // shard selection and reuses that hash for its own bucket lookup, so the
+    // core is reached through these prehashed helpers instead of find/insert.
+    // Aligned to a cache line so neighbouring shard locks never share one.
+    template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+    class alignas(cache_line_size) concurrent_shard
+        : public hash_map_core<Key, Value, Hash, KeyEqual, Allocator> {
+        using Base = hash_map_core<Key, Value, Hash, KeyEqual, Allocator>;
+
+    public:
+        mutable std::shared_mutex mutex;
+
+        using Base::Base;
+
+        template <typename K>
+        Value* find_hashed(const K& key, std::size_t hash) noexcept {
+            auto it = Base::find_hashed(key, hash);
+            return it != this->end() ? &it->second : nullptr;
+        }
+
+        template <typename K, typename... Args>
+        std::pair<Value*, bool> try_emplace_hashed(K&& key, std::size_t hash, Args&&... args) {
+            auto [it, inserted] = Base::try_emplace_hashed(std::forward<K>(key), hash, std::forward<Args>(args)...);
+            return { &it->second, inserted };
+        }
+
+        template <typename K>
+        bool erase_hashed(const K& key, std::size_t hash) noexcept {
+            return Base::erase_hashed(key, hash);
+        }
+    };
+
+} // namespace hash_map_impl
+
+// Thread-safe hash map that spreads keys over a power-of-two number of
+// hash_map_core shards, each guarded by its own reader-writer lock. Lookups
+// take a shared lock on one shard; writers lock only the shard they touch.
+//
+// Values are returned by copy (find) or accessed inside a callback (visit,
+// compute) so no reference escapes the lock that protects it.
+template <typename Key, typename Value,
+    typename Hash = default_hash_t<Key>,
+    typename KeyEqual = std::equal_to<>,
+    typename Allocator = std::allocator<std::pair<const Key, Value>>>
+    requires hash_map_impl::ValidHasher<Hash, Key>&&
+hash_map_impl::KeyComparator<KeyEqual, Key>
+class concurrent_hash_map {
+public:
+    using key_type = Key;
+    using mapped_type = Value;
+    using value_type = std::pair<const Key, Value>;
+    using size_type = std::size_t;
+    using hasher = Hash;
+    using key_equal = KeyEqual;
+    using allocator_type = Allocator;
+
+private:
+    using Shard = hash_map_impl::concurrent_shard<Key, Value, Hash, KeyEqual, Allocator>;
+    using ShardAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Shard>;
+
+    Shard* shards = nullptr;
+    size_type shard_count_ = 0;
+    Hash hash_fn;
+    [[no_unique_address]] Allocator alloc;
+
+    template <typename K>
+    static constexpr bool is_heterogeneous_v = std::is_same_v<K, key_type> ||
+        (Transparent<Hash> && Transparent<KeyEqual>);
+
+    // The shards index their buckets with the top bits of the hash, so the
+    // shard is chosen from a differently mixed copy of it.
+    size_type shard_index(std::size_t hash) const noexcept {
+        std::uint64_t h = hash;
+        h ^= h >> 32;
+        h *= 0xD6E8FEB86659FD93ULL;
+        h ^= h >> 32;
+        return static_cast<size_type>(h) & (shard_count_ - 1);
+    }
+
+    template <typename K>
+    std::pair<Shard&, std::size_t> locate(const K& key) const noexcept {
+        const auto hash = static_cast<std::size_t>(hash_fn(key));
+        return { shards[shard_index(hash)], hash };
+    }
+
+public:
+    static size_type default_shard_count() noexcept {
+        const auto threads = std::thread::hardware_concurrency();
+        return std::bit_ceil<size_type>(threads ? threads * 4 : 16);
+    }
+
+    explicit concurrent_hash_map(size_type shard_count = default_shard_count(),
+        size_type bucket_count = 16,
+        const Hash& hash = Hash(),
+        const KeyEqual& equal = KeyEqual(),
+        const Allocator& alloc = Allocator())
+        : shard_count_(std::bit_ceil(shard_count ? shard_count : size_type(1))), hash_fn(hash), alloc(alloc) {
+        ShardAllocator shard_alloc(alloc);
+        shards = std::allocator_traits<ShardAllocator>::allocate(shard_alloc, shard_count_);
+        size_type constructed = 0;
+        try {
+            for (; constructed < shard_count_; ++constructed) {
+                std::construct_at(shards + constructed, bucket_count, hash, equal, alloc);
+            }
+        }
+        catch (...) {
+            std::destroy_n(shards, constructed);
+            std::allocator_traits<ShardAllocator>::deallocate(shard_alloc, shards, shard_count_);
+            throw;
+        }
+    }
+
+    concurrent_hash_map(const concurrent_hash_map&) = delete;
+    concurrent_hash_map& operator=(const concurrent_hash_map&) = delete;
+
+    ~concurrent_hash_map() {
+        ShardAllocator shard_alloc(alloc);
+        std::destroy_n(shards, shard_count_);
+        std::allocator_traits<ShardAllocator>::deallocate(shard_alloc, shards, shard_count_);
+    }
+
+    // Copies the value out under a shared lock.
+    template <typename K>
+    [[nodiscard]] std::optional<Value> find(const K& key) const {
+        if constexpr (!is_heterogeneous_v<K>) {
+            return find(Key(key));
+        }
+        else {
+            auto [shard, hash] = locate(key);
+            std::shared_lock lock(shard.mutex);
+            if (auto* value = shard.find_hashed(key, hash)) {
+                return *value;
+            }
+            return std::nullopt;
+        }
+    }
+
+    template <typename K>
+    [[nodiscard]] bool contains(const K& key) const {
+        return visit(key, [](const Value&) {});
+    }
+
+    // Calls fn(const Value&) under a shared lock; returns whether the key was found.
+    template <typename K, typename F>
+    bool visit(const K& key, F&& fn) const {
+        if constexpr (!is_heterogeneous_v<K>) {
+            return visit(Key(key), std::forward<F>(fn));
+        }
+        else {
+            auto [shard, hash] = locate(key);
+            std::shared_lock lock(shard.mutex);
+            if (const auto* value = shard.find_hashed(key, hash)) {
+                std::invoke(std::forward<F>(fn), *value);
+                return true;
+            }
+            return false;
+        }
+    }
+
+    template <typename K, typename V>
+    bool insert(K&& key, V&& value) {
+        if constexpr (!is_heterogeneous_v<std::remove_cvref_t<K>>) {
+            return insert(Key(std::forward<K>(key)), std::forward<V>(value));
+        }
+        else {
+            auto [shard, hash] = locate(key);
+            std::unique_lock lock(shard.mutex);
+            return shard.try_emplace_hashed(std::forward<K>(key), hash, std::forward<V>(value)).second;
+        }
+    }
+
+    // Atomic upsert: inserts the pair or overwrites the existing value.
+    // Returns true if a new entry was created.
+    template <typename K, typename V>
+    bool insert_or_assign(K&& key, V&& value) {
+        if constexpr (!is_heterogeneous_v<std::remove_cvref_t<K>>) {
+            return insert_or_assign(Key(std::forward<K>(key)), std::forward<V>(value));
+        }
+        else {
+            auto [shard, hash] = locate(key);
+            std::unique_lock lock(shard.mutex);
+            // try_emplace_hashed leaves value untouched when the key exists,
+            // so it is still there to assign from.
+            auto [existing, inserted] = shard.try_emplace_hashed(std::forward<K>(key), hash, std::forward<V>(value));
+            if (!inserted) {
+                *existing = std::forward<V>(value);
+            }
+            return inserted;
+        }
+    }
+
+    // Atomic read-modify-write: calls fn(Value&) on the existing value, or on
+    // a value-initialized one inserted for the key, under the shard's
+    // exclusive lock, and returns whatever fn returns.
+    template <typename K, typename F>
+    decltype(auto) compute(K&& key, F&& fn) {
+        if constexpr (!is_heterogeneous_v<std::remove_cvref_t<K>>) {
+            return compute(Key(std::forward<K>(key)), std::forward<F>(fn));
+        }
+        else {
+            auto [shard, hash] = locate(key);
+            std::unique_lock lock(shard.mutex);
+            auto* value = shard.try_emplace_hashed(std::forward<K>(key), hash).first;
+            return std::invoke(std::forward<F>(fn), *value);
+        }
+    }
+
+    // Like compute, but only for keys that are already present.
+    template <typename K, typename F>
+    bool compute_if_present(const K& key, F&& fn) {
+        if constexpr (!is_heterogeneous_v<K>) {
+            return compute_if_present(Key(key), std::forward<F>(fn));
+        }
+        else {
+            auto [shard, hash] = locate(key);
+            std::unique_lock lock(shard.mutex);
+            if (auto* value = shard.find_hashed(key, hash)) {
+                std::invoke(std::forward<F>(fn), *value);
+                return true;
+            }
+            return false;
+        }
+    }
+
+    template <typename K>
+    size_type erase(const K& key) {
+        if constexpr (!is_heterogeneous_v<K>) {
+            return erase(Key(key));
+        }
+        else {
+            auto [shard, hash] = locate(key);
+            std::unique_lock lock(shard.mutex);
+            return shard.erase_hashed(key, hash) ? 1 : 0;
+        }
+    }
+
+    // Visits every entry, one shard at a time under that shard's shared lock.
+    // Not a snapshot: entries in shards not yet visited may still change.
+    template <typename F>
+    void for_each(F&& fn) const {
+        for (size_type i = 0; i < shard_count_; ++i) {
+            std::shared_lock lock(shards[i].mutex);
+            for (const auto& item : shards[i]) {
+                std::invoke(fn, item.first, item.second);
+            }
+        }
+    }
+
+    void clear() {
+        for (size_type i = 0; i < shard_count_; ++i) {
+            std::unique_lock lock(shards[i].mutex);
+            shards[i].clear();
+        }
+    }
+
+    // Sum of the shard sizes; exact only when no writer is running.
+    [[nodiscard]] size_type size() const {
+        size_type total = 0;
+        for (size_type i = 0; i < shard_count_; ++i) {
+            std::shared_lock lock(shards[i].mutex);
+            total += shards[i].size();
+        }
+        return total;
+    }
+
+    [[nodiscard]] bool empty() const { return size() == 0; }
+    [[nodiscard]] size_type shard_count() const noexcept { return shard_count_; }
+};
+
+#endif // CONCURRENT_HASH_MAP_H
@@ -0,0 +1,739 @@
+#ifndef FLAT_HASH_MAP_H
+#define FLAT_HASH_MAP_H
+
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <type_traits>
+#include <utility>
+#include <initializer_list>
+#include <iostream>
+#include <memory>
+
+#include "hashers.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FLAT_HASH_MAP_SSE2 1
+#endif
+
+namespace hash_map_impl {
+
+    // Control byte of a slot: empty, deleted (tombstone), the end-of-table
+    // sentinel, or - for a full slot - the low 7 bits of the key's hash.
+    using ctrl_t = std::int8_t;
+
+    inline constexpr ctrl_t ctrl_empty = -128;
+    inline constexpr ctrl_t ctrl_deleted = -2;
+    inline constexpr ctrl_t ctrl_sentinel = -1;
+
+    inline constexpr std::size_t group_width = 16;
+
+    // A window of group_width control bytes matched in one step.
+    // Each query returns a bitmask with bit i set for byte i.
+    class ctrl_group {
+#ifdef FLAT_HASH_MAP_SSE2
+        __m128i ctrl;
+
+    public:
+        explicit ctrl_group(const ctrl_t* pos) noexcept
+            : ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pos))) {
+        }
+
+        [[nodiscard]] std::uint32_t match(ctrl_t h2) const noexcept {
+            return static_cast<std::uint32_t>(
+                _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl)));
+        }
+
+        [[nodiscard]] std::uint32_t match_empty() const noexcept {
+            return match(ctrl_empty);
+        }
+
+        [[nodiscard]] std::uint32_t match_empty_or_deleted() const noexcept {
+            return static_cast<std::uint32_t>(
+                _mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(ctrl_sentinel), ctrl)));
+        }
+#else
+        ctrl_t ctrl[group_width];
+
+    public:
+        explicit ctrl_group(const ctrl_t* pos) noexcept {
+            std::memcpy(ctrl, pos, group_width);
+        }
+
+        [[nodiscard]] std::uint32_t match(ctrl_t h2) const noexcept {
+            std::uint32_t mask = 0;
+            for (std::size_t i = 0; i < group_width; ++i) {
+                mask |= static_cast<std::uint32_t>(ctrl[i] == h2) << i;
+            }
+            return mask;
+        }
+
+        [[nodiscard]] std::uint32_t match_empty() const noexcept {
+            return match(ctrl_empty);
+        }
+
+        [[nodiscard]] std::uint32_t match_empty_or_deleted() const noexcept {
+            std::uint32_t mask = 0;
+            for (std::size_t i = 0; i < group_width; ++i) {
+                mask |= static_cast<std::uint32_t>(ctrl[i] < ctrl_sentinel) << i;
+            }
+            return mask;
+        }
+#endif
+    };
+
+    // Triangular probing over groups; visits every group of a table whose
+    // capacity + 1 is a power of two exactly once.
+    class probe_seq {
+        std::size_t mask_;
+        std::size_t offset_;
+        std::size_t index_ = 0;
+
+    public:
+        probe_seq(std::size_t hash, std::size_t mask) noexcept
+            : mask_(mask), offset_(hash & mask) {
+        }
+
+        [[nodiscard]] std::size_t offset() const noexcept { return offset_; }
+        [[nodiscard]] std::size_t offset(std::size_t i) const noexcept { return (offset_ + i) & mask_; }
+
+        void next() noexcept {
+            index_ += group_width;
+            offset_ = (offset_ + index_) & mask_;
+        }
+    };
+
+    // Finalizer from MurmurHash3; spreads identity hashes such as
+    // std::hash<int> over both the H1 and H2 parts.
+    [[nodiscard]] constexpr std::uint64_t mix_hash(std::uint64_t h) noexcept {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+    [[nodiscard]] constexpr std::size_t h1(std::size_t hash) noexcept { return hash >> 7; }
+    [[nodiscard]] constexpr ctrl_t h2(std::size_t hash) noexcept { return static_cast<ctrl_t>(hash & 0x7F); }
+
+    // Control bytes of an open-addressing table and its growth budget. The
+    // maps keep their entries in arrays of their own, indexed like the
+    // control bytes: this class finds, claims and frees slot indices but
+    // never touches an entry. The first group_width - 1 bytes are mirrored
+    // after the sentinel, so a group read at any slot stays in bounds.
+    template <typename Allocator>
+    class ctrl_table {
+        using CtrlAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<ctrl_t>;
+        using CtrlTraits = std::allocator_traits<CtrlAllocator>;
+
+        ctrl_t* ctrl_ = nullptr;
+        std::size_t capacity_ = 0;
+        std::size_t growth_left_ = 0;
+        [[no_unique_address]] CtrlAllocator alloc;
+
+        void set_ctrl(std::size_t i, ctrl_t c) noexcept {
+            ctrl_[i] = c;
+            if (i < group_width - 1) {
+                ctrl_[capacity_ + 1 + i] = c;
+            }
+        }
+
+    public:
+        static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+        static constexpr std::size_t min_capacity = group_width - 1;
+
+        static constexpr std::size_t normalize_capacity(std::size_t n) noexcept {
+            return n <= min_capacity ? min_capacity : std::bit_ceil(n + 1) - 1;
+        }
+
+        // Keeps at least capacity / 8 slots empty so every probe terminates.
+        static constexpr std::size_t capacity_to_growth(std::size_t capacity) noexcept {
+            return capacity - capacity / 8;
+        }
+
+        // No table yet; allocated() is false.
+        explicit ctrl_table(const Allocator& a) noexcept : alloc(a) {
+        }
+
+        // All slots empty, with the growth budget of a table that is about
+        // to receive size entries.
+        ctrl_table(std::size_t capacity, std::size_t size, const Allocator& a)
+            : ctrl_(nullptr), capacity_(capacity), alloc(a) {
+            ctrl_ = CtrlTraits::allocate(alloc, capacity + group_width);
+            reset();
+            growth_left_ -= size;
+        }
+
+        ctrl_table(ctrl_table&& other) noexcept
+            : ctrl_(std::exchange(other.ctrl_, nullptr)),
+            capacity_(std::exchange(other.capacity_, 0)),
+            growth_left_(std::exchange(other.growth_left_, 0)),
+            alloc(other.alloc) {
+        }
+
+        ctrl_table& operator=(ctrl_table other) noexcept {
+            swap(other);
+            return *this;
+        }
+
+        ~ctrl_table() {
+            if (ctrl_) {
+                CtrlTraits::deallocate(alloc, ctrl_, capacity_ + group_width);
+            }
+        }
+
+        void swap(ctrl_table& other) noexcept {
+            using std::swap;
+            swap(ctrl_, other.ctrl_);
+            swap(capacity_, other.capacity_);
+            swap(growth_left_, other.growth_left_);
+            swap(alloc, other.alloc);
+        }
+
+        [[nodiscard]] bool allocated() const noexcept { return ctrl_ != nullptr; }
+        [[nodiscard]] const ctrl_t* data() const noexcept { return ctrl_; }
+        [[nodiscard]] std::size_t capacity() const noexcept { return capacity_; }
+        [[nodiscard]] bool is_full(std::size_t i) const noexcept { return ctrl_[i] >= 0; }
+
+        // Takes over the control bytes of a table of the same capacity, so
+        // entries copied slot by slot alongside keep their positions.
+        void copy_from(const ctrl_table& other) noexcept {
+            std::memcpy(ctrl_, other.ctrl_, capacity_ + group_width);
+            growth_left_ = other.growth_left_;
+        }
+
+        // Index of the full slot for hash at which matches(index) holds, or
+        // npos. Only slots whose control byte carries the hash's H2 are tried.
+        template <typename Match>
+        [[nodiscard]] std::size_t find(std::size_t hash, Match&& matches) const {
+            const auto tag = h2(hash);
+            probe_seq seq(h1(hash), capacity_);
+            while (true) {
+                ctrl_group group(ctrl_ + seq.offset());
+                for (auto bits = group.match(tag); bits; bits &= bits - 1) {
+                    const auto idx = seq.offset(std::countr_zero(bits));
+                    if (matches(idx)) {
+                        return idx;
+                    }
+                }
+                if (group.match_empty()) {
+                    return npos;
+                }
+                seq.next();
+            }
+        }
+
+        [[nodiscard]] std::size_t find_first_non_full(std::size_t hash) const noexcept {
+            probe_seq seq(h1(hash), capacity_);
+            while (true) {
+                ctrl_group group(ctrl_ + seq.offset());
+                if (auto bits = group.match_empty_or_deleted()) {
+                    return seq.offset(std::countr_zero(bits));
+                }
+                seq.next();
+            }
+        }
+
+        [[nodiscard]] bool needs_growth() const noexcept { return growth_left_ == 0; }
+
+        // Capacity to rehash to once the growth budget is used up: the same
+        // one, dropping tombstones in place, when they rather than live
+        // entries used it up; otherwise the next larger one.
+        [[nodiscard]] std::size_t grown_capacity(std::size_t size) const noexcept {
+            return size <= capacity_to_growth(capacity_) / 2 ? capacity_ : capacity_ * 2 + 1;
+        }
+
+        // Marks slot idx, from find_first_non_full, as full for hash. Called
+        // once its entry is constructed.
+        void claim(std::size_t idx, std::size_t hash) noexcept {
+            if (ctrl_[idx] == ctrl_empty) {
+                --growth_left_;
+            }
+            set_ctrl(idx, h2(hash));
+        }
+
+        // Frees slot idx, whose entry has been destroyed.
+        void release(std::size_t idx) noexcept {
+            // A slot may go back to empty only if no probe could have passed
+            // over it, i.e. no full window of group_width bytes contains it.
+            const auto idx_before = (idx - group_width) & capacity_;
+            const auto empty_after = ctrl_group(ctrl_ + idx).match_empty();
+            const auto empty_before = ctrl_group(ctrl_ + idx_before).match_empty();
+            const bool was_never_full = empty_before && empty_after &&
+                static_cast<std::size_t>(std::countr_zero(empty_after) +
+                    std::countl_zero(static_cast<std::uint16_t>(empty_before))) < group_width;
+
+            if (was_never_full) {
+                set_ctrl(idx, ctrl_empty);
+                ++growth_left_;
+            }
+            else {
+                set_ctrl(idx, ctrl_deleted);
+            }
+        }
+
+        // Marks every slot empty; the entries must already be destroyed.
+        void reset() noexcept {
+            if (ctrl_) {
+                std::memset(ctrl_, static_cast<unsigned char>(ctrl_empty), capacity_ + group_width);
+                ctrl_[capacity_] = ctrl_sentinel;
+                growth_left_ = capacity_to_growth(capacity_);
+            }
+        }
+
+        // Fills this fresh table with the full slots of old: hash_at(i) is
+        // the hash of old slot i and move(i, idx) relocates its entry to idx.
+        template <typename HashAt, typename Move>
+        void rebuild_from(const ctrl_table& old, HashAt&& hash_at, Move&& move) {
+            for (std::size_t i = 0; i < old.capacity_; ++i) {
+                if (old.is_full(i)) {
+                    const auto hash = hash_at(i);
+                    const auto idx = find_first_non_full(hash);
+                    set_ctrl(idx, h2(hash));
+                    move(i, idx);
+                }
+            }
+        }
+    };
+
+} // namespace hash_map_impl
+
+// Open-addressing hash map with the same find/insert/erase/operator[] API as
+// hash_map. Entries live inline in one slot array; a parallel array of control
+// bytes is probed group_width slots at a time, so a lookup touches the control
+// bytes and, on a 7-bit hash match, the slot itself.
+template <typename Key, typename Value,
+    typename Hash = default_hash_t<Key>,
+    typename KeyEqual = std::equal_to<>,
+    typename Allocator = std::allocator<std::pair<const Key, Value>>>
+    requires std::is_invocable_r_v<std::size_t, const Hash&, const Key&>
+class flat_hash_map {
+public:
+    using key_type = Key;
+    using mapped_type = Value;
+    using value_type = std::pair<const Key, Value>;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using hasher = Hash;
+    using key_equal = KeyEqual;
+    using allocator_type = Allocator;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using pointer = typename std::allocator_traits<Allocator>::pointer;
+    using const_pointer = typename std::allocator_traits<Allocator>::const_pointer;
+
+private:
+    using ctrl_t = hash_map_impl::ctrl_t;
+
+    // The mutable view lets rehash move keys instead of copying them.
+    union slot_type {
+        value_type value;
+        std::pair<Key, Value> mutable_value;
+
+        slot_type() noexcept {}
+        ~slot_type() {}
+    };
+
+    using SlotAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<slot_type>;
+    using SlotTraits = std::allocator_traits<SlotAllocator>;
+    using table_type = hash_map_impl::ctrl_table<Allocator>;
+
+    Hash hash_fn;
+    KeyEqual key_eq;
+    [[no_unique_address]] Allocator alloc;
+    table_type table;
+    slot_type* slots_ = nullptr;
+    size_type element_count = 0;
+
+    // Keys of another type are hashed and compared as-is only when both
+    // Hash and KeyEqual are transparent; otherwise they are converted once.
+    template <typename K>
+    static constexpr bool is_heterogeneous_v = std::is_same_v<K, key_type> ||
+        (Transparent<Hash> && Transparent<KeyEqual>);
+
+    template <typename K>
+    size_type hash_of(const K& key) const noexcept {
+        if constexpr (requires { typename Hash::is_avalanching; }) {
+            return static_cast<size_type>(hash_fn(key));
+        }
+        else {
+            return static_cast<size_type>(hash_map_impl::mix_hash(hash_fn(key)));
+        }
+    }
+
+    slot_type* allocate_slots(size_type capacity) {
+        SlotAllocator slot_alloc(alloc);
+        return SlotTraits::allocate(slot_alloc, capacity);
+    }
+
+    void deallocate_slots(slot_type* slots, size_type capacity) noexcept {
+        if (slots) {
+            SlotAllocator slot_alloc(alloc);
+            SlotTraits::deallocate(slot_alloc, slots, capacity);
+        }
+    }
+
+    // For a map without a table.
+    void allocate_table(size_type capacity) {
+        table_type fresh(capacity, element_count, alloc);
+        slots_ = allocate_slots(capacity);
+        table = std::move(fresh);
+    }
+
+    void destroy_slots() noexcept {
+        if constexpr (!std::is_trivially_destructible_v<value_type>) {
+            SlotAllocator slot_alloc(alloc);
+            for (size_type i = 0; i < table.capacity(); ++i) {
+                if (table.is_full(i)) {
+                    SlotTraits::destroy(slot_alloc, &slots_[i].value);
+                }
+            }
+        }
+    }
+
+    template <typename K>
+    slot_type* find_slot(const K& key, size_type hash) const noexcept {
+        const auto idx = table.find(hash, [&](size_type i) { return key_eq(slots_[i].value.first, key); });
+        return idx != table_type::npos ? slots_ + idx : nullptr;
+    }
+
+    void resize(size_type new_capacity) {
+        table_type fresh(new_capacity, element_count, alloc);
+        slot_type* new_slots = allocate_slots(new_capacity);
+
+        SlotAllocator slot_alloc(alloc);
+        fresh.rebuild_from(table,
+            [&](size_type i) { return hash_of(slots_[i].value.first); },
+            [&](size_type from, size_type to) {
+                SlotTraits::construct(slot_alloc, &new_slots[to].mutable_value, std::move(slots_[from].mutable_value));
+                SlotTraits::destroy(slot_alloc, &slots_[from].mutable_value);
+            });
+
+        deallocate_slots(slots_, table.capacity());
+        slots_ = new_slots;
+        table = std::move(fresh);
+    }
+
+    template <typename K, typename... Args>
+    std::pair<slot_type*, bool> find_or_prepare_insert(const K& key, Args&&... args) {
+        auto hash = hash_of(key);
+        if (auto* slot = find_slot(key, hash)) {
+            return { slot, false };
+        }
+        if (table.needs_growth()) {
+            resize(table.grown_capacity(element_count));
+        }
+        const auto idx = table.find_first_non_full(hash);
+        SlotAllocator slot_alloc(alloc);
+        SlotTraits::construct(slot_alloc, &slots_[idx].value, std::forward<Args>(args)...);
+        table.claim(idx, hash);
+        ++element_count;
+        return { slots_ + idx, true };
+    }
+
+    void erase_slot(slot_type* slot) noexcept {
+        SlotAllocator slot_alloc(alloc);
+        SlotTraits::destroy(slot_alloc, &slot->value);
+        --element_count;
+        table.release(static_cast<size_type>(slot - slots_));
+    }
+
+public:
+
+    template <bool IsConst>
+    class Iterator {
+        friend class flat_hash_map;
+
+        using SlotPointer = std::conditional_t<IsConst, const slot_type*, slot_type*>;
+
+        const ctrl_t* ctrl;
+        SlotPointer slot;
+
+        void skip_empty_slots() {
+            while (*ctrl < hash_map_impl::ctrl_sentinel) {
+                ++ctrl;
+                ++slot;
+            }
+        }
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::pair<const Key, Value>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<IsConst, const value_type*, value_type*>;
+        using reference = std::conditional_t<IsConst, const value_type&, value_type&>;
+
+        Iterator() noexcept : ctrl(nullptr), slot(nullptr) {}
+
+        Iterator(const ctrl_t* c, SlotPointer s)
+            : ctrl(c), slot(s) {
+            skip_empty_slots();
+        }
+
+        operator Iterator<true>() const noexcept { return Iterator<true>(ctrl, slot); }
+
+        Iterator& operator++() {
+            ++ctrl;
+            ++slot;
+            skip_empty_slots();
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            Iterator tmp = *this;
+            ++(*this);
+            return tmp;
+        }
+
+        reference operator*() const { return slot->value; }
+        pointer operator->() const { return &slot->value; }
+
+        bool operator==(const Iterator& other) const { return ctrl == other.ctrl; }
+        bool operator!=(const Iterator& other) const { return !(*this == other); }
+    };
+
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    explicit flat_hash_map(size_type bucket_count = 16,
+        const Hash& hash = Hash(),
+        const KeyEqual& equal = KeyEqual(),
+        const Allocator& alloc = Allocator())
+        : hash_fn(hash), key_eq(equal), alloc(alloc), table(alloc) {
+        allocate_table(table_type::normalize_capacity(bucket_count));
+    }
+
+    flat_hash_map(std::initializer_list<value_type> init,
+        size_type bucket_count = 16,
+        const Hash& hash = Hash(),
+        const KeyEqual& equal = KeyEqual(),
+        const Allocator& alloc = Allocator())
+        : flat_hash_map(bucket_count, hash, equal, alloc) {
+        reserve(init.size());
+        for (const auto& pair : init) {
+            insert(pair.first, pair.second);
+        }
+    }
+
+    flat_hash_map(const flat_hash_map& other)
+        : hash_fn(other.hash_fn),
+        key_eq(other.key_eq),
+        alloc(std::allocator_traits<Allocator>::select_on_container_copy_construction(other.alloc)),
+        table(alloc) {
+        if (!other.table.allocated()) {
+            return;
+        }
+        // Same capacity, so every element keeps its slot and the control
+        // bytes are copied verbatim; nothing is rehashed.
+        const auto capacity = other.table.capacity();
+        allocate_table(capacity);
+        if constexpr (std::is_trivially_copy_constructible_v<value_type> &&
+            std::is_trivially_destructible_v<value_type>) {
+            std::memcpy(static_cast<void*>(slots_), other.slots_, capacity * sizeof(slot_type));
+        }
+        else {
+            SlotAllocator slot_alloc(alloc);
+            size_type i = 0;
+            try {
+                for (; i < capacity; ++i) {
+                    if (other.table.is_full(i)) {
+                        SlotTraits::construct(slot_alloc, &slots_[i].value, other.slots_[i].value);
+                    }
+                }
+            }
+            catch (...) {
+                while (i-- > 0) {
+                    if (other.table.is_full(i)) {
+                        SlotTraits::destroy(slot_alloc, &slots_[i].value);
+                    }
+                }
+                deallocate_slots(slots_, capacity);
+                throw;
+            }
+        }
+        table.copy_from(other.table);
+        element_count = other.element_count;
+    }
+
+    flat_hash_map(flat_hash_map&& other) noexcept
+        : hash_fn(std::move(other.hash_fn)),
+        key_eq(std::move(other.key_eq)),
+        alloc(std::move(other.alloc)),
+        table(std::move(other.table)),
+        slots_(std::exchange(other.slots_, nullptr)),
+        element_count(std::exchange(other.element_count, 0)) {
+    }
+
+    flat_hash_map& operator=(flat_hash_map other) noexcept {
+        swap(other);
+        return *this;
+    }
+
+    ~flat_hash_map() {
+        destroy_slots();
+        deallocate_slots(slots_, table.capacity());
+    }
+
+    void swap(flat_hash_map& other) noexcept {
+        using std::swap;
+        swap(hash_fn, other.hash_fn);
+        swap(key_eq, other.key_eq);
+        swap(alloc, other.alloc);
+        table.swap(other.table);
+        swap(slots_, other.slots_);
+        swap(element_count, other.element_count);
+    }
+
+    [[nodiscard]] iterator begin() noexcept {
+        return table.allocated() ? iterator(table.data(), slots_) : end();
+    }
+
+    [[nodiscard]] const_iterator begin() const noexcept {
+        return table.allocated() ? const_iterator(table.data(), slots_) : end();
+    }
+
+    [[nodiscard]] const_iterator cbegin() const noexcept {
+        return begin();
+    }
+
+    [[nodiscard]] iterator end() noexcept {
+        iterator it;
+        it.ctrl = table.data() + table.capacity();
+        it.slot = slots_ + table.capacity();
+        return it;
+    }
+
+    [[nodiscard]] const_iterator end() const noexcept {
+        const_iterator it;
+        it.ctrl = table.data() + table.capacity();
+        it.slot = slots_ + table.capacity();
+        return it;
+    }
+
+    [[nodiscard]] const_iterator cend() const noexcept {
+        return end();
+    }
+
+    template <typename K>
+    [[nodiscard]] Value* find(const K& key) noexcept {
+        if constexpr (!is_heterogeneous_v<K>) {
+            return find(Key(key));
+        }
+        else {
+            if (!table.allocated()) {
+                return nullptr;
+            }
+            auto* slot = find_slot(key, hash_of(key));
+            return slot ? &slot->value.second : nullptr;
+        }
+    }
+
+    template <typename K>
+    [[nodiscard]] const Value* find(const K& key) const noexcept {
+        return const_cast<flat_hash_map*>(this)->find(key);
+    }
+
+    template <typename K>
+    Value& operator[](K&& key) {
+        if constexpr (!is_heterogeneous_v<std::remove_cvref_t<K>>) {
+            return (*this)[Key(std::forward<K>(key))];
+        }
+        else {
+            ensure_table();
+            auto [slot, inserted] = find_or_prepare_insert(key, std::piecewise_construct,
+                std::forward_as_tuple(std::forward<K>(key)), std::forward_as_tuple());
+            return slot->value.second;
+        }
+    }
+
+    template <typename K, typename V>
+    std::pair<iterator, bool> insert(K&& key, V&& value) {
+        if constexpr (!is_heterogeneous_v<std::remove_cvref_t<K>>) {
+            return insert(Key(std::forward<K>(key)), std::forward<V>(value));
+        }
+        else {
+            ensure_table();
+            auto [slot, inserted] = find_or_prepare_insert(key, std::forward<K>(key), std::forward<V>(value));
+            return { iterator(table.data() + (slot - slots_), slot), inserted };
+        }
+    }
+
+    template <typename K>
+    size_type erase(const K& key) noexcept {
+        if constexpr (!is_heterogeneous_v<K>) {
+            return erase(Key(key));
+        }
+        else {
+            if (!table.allocated()) {
+                return 0;
+            }
+            if (auto* slot = find_slot(key, hash_of(key))) {
+                erase_slot(slot);
+                return 1;
+            }
+            return 0;
+        }
+    }
+
+    void clear() noexcept {
+        destroy_slots();
+        element_count = 0;
+        table.reset();
+    }
+
+    [[nodiscard]] size_type size() const noexcept { return element_count; }
+    [[nodiscard]] bool empty() const noexcept { return element_count == 0; }
+    [[nodiscard]] size_type bucket_count() const noexcept { return table.capacity(); }
+
+    [[nodiscard]] float load_factor() const noexcept {
+        return table.capacity() ? static_cast<float>(element_count) / table.capacity() : 0.0f;
+    }
+
+    [[nodiscard]] float max_load_factor() const noexcept {
+        return 7.0f / 8.0f;
+    }
+
+    void rehash(size_type count) {
+        auto capacity = table_type::normalize_capacity(count);
+        while (table_type::capacity_to_growth(capacity) < element_count) {
+            capacity = capacity * 2 + 1;
+        }
+        resize(capacity);
+    }
+
+    void reserve(size_type count) {
+        if (!table.allocated() || table_type::capacity_to_growth(table.capacity()) < count) {
+            rehash(count + count / 7);
+        }
+    }
+
+    void print(std::ostream& os = std::cout) const {
+        os << "Flat Hash Map (size: " << size()
+            << ", capacity: " << bucket_count()
+            << ", load factor: " << load_factor() << ")\n";
+
+        for (size_type i = 0; i < table.capacity(); ++i) {
+            if (table.is_full(i)) {
+                os << "  [" << i << "] {" << slots_[i].value.first << ": " << slots_[i].value.second << "}\n";
+            }
+        }
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, const flat_hash_map& map) {
+        map.print(os);
+        return os;
+    }
+
+private:
+    // A moved-from map has no table; the next insertion gives it one.
+    void ensure_table() {
+        if (!table.allocated()) {
+            allocate_table(table_type::min_capacity);
+        }
+    }
+};
+
+#endif // FLAT_HASH_MAP_H
@@ -0,0 +1,240 @@
+#ifndef FROZEN_HASH_MAP_H
+#define FROZEN_HASH_MAP_H
+
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace hash_map_impl {
+
+    // MurmurHash3 finalizer, usable in constant expressions.
+    [[nodiscard]] constexpr std::uint64_t frozen_mix(std::uint64_t h) noexcept {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+} // namespace hash_map_impl
+
+// std::hash is not constexpr, so frozen maps hash through this instead.
+// Covers integers, enums and anything convertible to std::string_view.
+template <typename Key>
+struct frozen_hash;
+
+template <typename Key>
+    requires std::integral<Key> || std::is_enum_v<Key>
+struct frozen_hash<Key> {
+    [[nodiscard]] constexpr std::uint64_t operator()(Key key) const noexcept {
+        return hash_map_impl::frozen_mix(static_cast<std::uint64_t>(key));
+    }
+};
+
+template <>
+struct frozen_hash<std::string_view> {
+    using is_transparent = void;
+
+    // FNV-1a, then mixed so that short keys still differ in the high bits.
+    [[nodiscard]] constexpr std::uint64_t operator()(std::string_view s) const noexcept {
+        std::uint64_t h = 0xcbf29ce484222325ULL;
+        for (char c : s) {
+            h = (h ^ static_cast<unsigned char>(c)) * 0x100000001b3ULL;
+        }
+        return hash_map_impl::frozen_mix(h ^ s.size());
+    }
+};
+
+// Read-only map over a key/value list fixed at compile time, built with
+// hash-and-displace perfect hashing. Keys are split into groups of about four
+// by one mix of the hash; each group, largest first, is assigned the first
+// displacement that sends all of its keys to free slots. A lookup is then one
+// hash, one displacement read, one slot read and one key comparison, with no
+// probing and no loop.
+//
+// Build it in a constant expression, normally through make_frozen_hash_map:
+//
+//     constexpr auto opcodes = make_frozen_hash_map<std::string_view, int>({
+//         { "add", 0x01 }, { "sub", 0x02 }, { "mul", 0x03 },
+//     });
+//     static_assert(*opcodes.find("sub") == 0x02);
+//
+// Duplicate keys are a compile error. Key and Value must be literal types.
+template <typename Key, typename Value, std::size_t N,
+    typename Hash = frozen_hash<Key>,
+    typename KeyEqual = std::equal_to<>>
+class frozen_hash_map {
+public:
+    using key_type = Key;
+    using mapped_type = Value;
+    using value_type = std::pair<Key, Value>;
+    using size_type = std::size_t;
+    using hasher = Hash;
+    using key_equal = KeyEqual;
+    using const_iterator = const value_type*;
+    using iterator = const_iterator;
+
+private:
+    using index_type = std::uint32_t;
+
+    // Slots are kept below 8/9 full and groups average four keys.
+    static constexpr size_type table_size = std::bit_ceil(N + N / 8 + 1);
+    static constexpr size_type group_count = std::bit_ceil(N / 4 + 1);
+    static constexpr index_type empty_slot = static_cast<index_type>(N);
+    static constexpr index_type max_displacement = 1u << 16;
+    static constexpr int max_seeds = 64;
+
+    std::array<value_type, N> items{};
+    std::array<index_type, group_count> displacement{};
+    std::array<index_type, table_size> slots{};
+    std::uint64_t seed = 0;
+    [[no_unique_address]] Hash hash_fn;
+    [[no_unique_address]] KeyEqual key_eq;
+
+    constexpr size_type group_of(std::uint64_t hash) const noexcept {
+        return static_cast<size_type>(hash_map_impl::frozen_mix(hash ^ seed)) & (group_count - 1);
+    }
+
+    static constexpr size_type slot_of(std::uint64_t hash, index_type d) noexcept {
+        return static_cast<size_type>(hash_map_impl::frozen_mix(hash ^ (d * 0x9E3779B97F4A7C15ULL))) & (table_size - 1);
+    }
+
+    // One attempt with the current seed. Fails if some group finds no
+    // displacement, in which case the caller retries with another seed.
+    constexpr bool build(const std::array<std::uint64_t, N>& hashes) {
+        // Counting sort of item indices by group.
+        std::array<size_type, group_count + 1> offsets{};
+        for (size_type i = 0; i < N; ++i) {
+            ++offsets[group_of(hashes[i]) + 1];
+        }
+        for (size_type g = 0; g < group_count; ++g) {
+            offsets[g + 1] += offsets[g];
+        }
+        std::array<index_type, N> members{};
+        auto fill = offsets;
+        for (size_type i = 0; i < N; ++i) {
+            members[fill[group_of(hashes[i])]++] = static_cast<index_type>(i);
+        }
+
+        // Groups largest first, while the table still has room for them.
+        std::array<index_type, group_count> order{};
+        for (size_type g = 0; g < group_count; ++g) {
+            order[g] = static_cast<index_type>(g);
+        }
+        auto group_size = [&](index_type g) { return offsets[g + 1] - offsets[g]; };
+        for (size_type i = 1; i < group_count; ++i) {
+            for (size_type j = i; j > 0 && group_size(order[j - 1]) < group_size(order[j]); --j) {
+                std::swap(order[j - 1], order[j]);
+            }
+        }
+
+        slots.fill(empty_slot);
+        displacement.fill(0);
+        for (auto g : order) {
+            const auto first = offsets[g];
+            const auto last = offsets[g + 1];
+            if (first == last) {
+                break;
+            }
+
+            // Keys with equal full hashes share a group under every seed and
+            // can never be separated by a displacement.
+            for (auto i = first; i < last; ++i) {
+                for (auto j = first; j < i; ++j) {
+                    if (hashes[members[i]] == hashes[members[j]]) {
+                        throw std::invalid_argument(key_eq(items[members[i]].first, items[members[j]].first)
+                            ? "frozen_hash_map: duplicate key"
+                            : "frozen_hash_map: full hash collision");
+                    }
+                }
+            }
+
+            index_type d = 0;
+            for (; d < max_displacement; ++d) {
+                bool fits = true;
+                for (auto i = first; i < last && fits; ++i) {
+                    const auto slot = slot_of(hashes[members[i]], d);
+                    fits = slots[slot] == empty_slot;
+                    for (auto j = first; j < i && fits; ++j) {
+                        fits = slot_of(hashes[members[j]], d) != slot;
+                    }
+                }
+                if (fits) {
+                    break;
+                }
+            }
+            if (d == max_displacement) {
+                return false;
+            }
+
+            displacement[g] = d;
+            for (auto i = first; i < last; ++i) {
+                slots[slot_of(hashes[members[i]], d)] = members[i];
+            }
+        }
+        return true;
+    }
+
+public:
+    explicit constexpr frozen_hash_map(const std::array<value_type, N>& init,
+        const Hash& hash = Hash(),
+        const KeyEqual& equal = KeyEqual())
+        : items(init), hash_fn(hash), key_eq(equal) {
+        std::array<std::uint64_t, N> hashes{};
+        for (size_type i = 0; i < N; ++i) {
+            hashes[i] = hash_fn(items[i].first);
+        }
+
+        for (int attempt = 0; attempt < max_seeds; ++attempt) {
+            seed = hash_map_impl::frozen_mix(static_cast<std::uint64_t>(attempt) + 1);
+            if (build(hashes)) {
+                return;
+            }
+        }
+        throw std::runtime_error("frozen_hash_map: no perfect hash found");
+    }
+
+    template <typename K>
+    [[nodiscard]] constexpr const Value* find(const K& key) const noexcept {
+        const std::uint64_t hash = hash_fn(key);
+        const auto index = slots[slot_of(hash, displacement[group_of(hash)])];
+        return index != empty_slot && key_eq(items[index].first, key) ? &items[index].second : nullptr;
+    }
+
+    template <typename K>
+    [[nodiscard]] constexpr bool contains(const K& key) const noexcept {
+        return find(key) != nullptr;
+    }
+
+    // Entries in the order they were given.
+    [[nodiscard]] constexpr const_iterator begin() const noexcept { return items.data(); }
+    [[nodiscard]] constexpr const_iterator end() const noexcept { return items.data() + N; }
+
+    [[nodiscard]] static constexpr size_type size() noexcept { return N; }
+    [[nodiscard]] static constexpr bool empty() noexcept { return N == 0; }
+    [[nodiscard]] static constexpr size_type bucket_count() noexcept { return table_size; }
+};
+
+// Builds a frozen_hash_map at compile time from a braced list of pairs,
+// deducing its size.
+template <typename Key, typename Value,
+    typename Hash = frozen_hash<Key>,
+    typename KeyEqual = std::equal_to<>,
+    std::size_t N>
+consteval frozen_hash_map<Key, Value, N, Hash, KeyEqual>
+make_frozen_hash_map(const std::pair<Key, Value>(&items)[N]) {
+    std::array<std::pair<Key, Value>, N> init{};
+    for (std::size_t i = 0; i < N; ++i) {
+        init[i] = items[i];
+    }
+    return frozen_hash_map<Key, Value, N, Hash, KeyEqual>(init);
+}
+
+#endif // FROZEN_HASH_MAP_H
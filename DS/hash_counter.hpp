@@ -0,0 +1,163 @@
+#ifndef HASH_COUNTER_H
+#define HASH_COUNTER_H
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "hash_map.hpp"
+
+// Frequency counter on top of hash_map. increment() finds or inserts its key
+// in a single chain walk, add_all() counts a whole span through
+// hash_map::update_batch, and top_k() selects the most frequent keys with a
+// k-entry heap instead of copying or sorting the table.
+//
+// For multi-threaded counting, give each thread its own counter and merge
+// them afterwards; merging an rvalue moves its nodes over without
+// allocating for keys the target has not seen.
+template <typename Key, typename Count = std::uint64_t,
+    typename Hash = default_hash_t<Key>,
+    typename KeyEqual = std::equal_to<>,
+    typename Allocator = std::allocator<std::pair<const Key, Count>>>
+    requires std::is_arithmetic_v<Count>
+class hash_counter {
+public:
+    using key_type = Key;
+    using count_type = Count;
+    using value_type = std::pair<const Key, Count>;
+    using size_type = std::size_t;
+    using hasher = Hash;
+    using key_equal = KeyEqual;
+    using allocator_type = Allocator;
+
+private:
+    using Map = hash_map<Key, Count, Hash, KeyEqual, Allocator>;
+
+    Map counts;
+
+public:
+    using const_iterator = typename Map::const_iterator;
+
+    explicit hash_counter(size_type bucket_count = 16,
+        const Hash& hash = Hash(),
+        const KeyEqual& equal = KeyEqual(),
+        const Allocator& alloc = Allocator())
+        : counts(bucket_count, hash, equal, alloc) {
+    }
+
+    // Adds delta to the count of key, starting from 0, and returns the new
+    // count.
+    template <typename K>
+    Count increment(K&& key, Count delta = 1) {
+        return counts[std::forward<K>(key)] += delta;
+    }
+
+    // Counts every key of the span once.
+    template <typename K, std::size_t Extent>
+    void add_all(std::span<K, Extent> keys) {
+        counts.update_batch(keys, [](size_type, Count& count) { ++count; });
+    }
+
+    // Adds deltas[i] to the count of keys[i]; deltas must be at least as
+    // long as keys.
+    template <typename K, std::size_t Extent>
+    void add_all(std::span<K, Extent> keys, std::span<const Count> deltas) {
+        counts.update_batch(keys, [&](size_type i, Count& count) { count += deltas[i]; });
+    }
+
+    template <typename K>
+    [[nodiscard]] Count count(const K& key) const noexcept {
+        auto* value = counts.find(key);
+        return value ? *value : Count();
+    }
+
+    template <typename K>
+    [[nodiscard]] bool contains(const K& key) const noexcept {
+        return counts.find(key) != nullptr;
+    }
+
+    template <typename K>
+    size_type erase(const K& key) noexcept {
+        return counts.erase(key);
+    }
+
+    // Adds every count of other to this counter.
+    void merge(const hash_counter& other) {
+        counts.reserve(counts.size() + other.size());
+        for (const auto& [key, count] : other.counts) {
+            counts[key] += count;
+        }
+    }
+
+    // The smaller counter is folded into the larger one. Keys new to it are
+    // spliced over as nodes; only shared keys are looked up and added. Nodes
+    // cannot change allocators, so counters whose allocators differ merge
+    // key by key as above.
+    void merge(hash_counter&& other) {
+        if (counts.get_allocator() != other.counts.get_allocator()) {
+            merge(static_cast<const hash_counter&>(other));
+            other.counts.clear();
+            return;
+        }
+        if (other.size() > size()) {
+            counts.swap(other.counts);
+        }
+        counts.merge(other.counts);
+        for (const auto& [key, count] : other.counts) {
+            counts[key] += count;
+        }
+        other.counts.clear();
+    }
+
+    // The k most frequent keys with their counts, most frequent first; ties
+    // come in no particular order. O(size() log k) time and O(k) memory: a
+    // min-heap of pointers to the best k entries seen so far, each new entry
+    // only compared with its root.
+    [[nodiscard]] std::vector<std::pair<Key, Count>> top_k(size_type k) const {
+        std::vector<std::pair<Key, Count>> result;
+        if (k == 0) {
+            return result;
+        }
+
+        using entry = const value_type*;
+        auto more_frequent = [](entry a, entry b) { return a->second > b->second; };
+        std::vector<entry> heap;
+        heap.reserve(std::min(k, size()));
+        for (const auto& item : counts) {
+            if (heap.size() < k) {
+                heap.push_back(&item);
+                std::push_heap(heap.begin(), heap.end(), more_frequent);
+            }
+            else if (item.second > heap.front()->second) {
+                std::pop_heap(heap.begin(), heap.end(), more_frequent);
+                heap.back() = &item;
+                std::push_heap(heap.begin(), heap.end(), more_frequent);
+            }
+        }
+        std::sort_heap(heap.begin(), heap.end(), more_frequent);
+
+        result.reserve(heap.size());
+        for (auto* item : heap) {
+            result.emplace_back(item->first, item->second);
+        }
+        return result;
+    }
+
+    [[nodiscard]] const_iterator begin() const noexcept { return counts.begin(); }
+    [[nodiscard]] const_iterator end() const noexcept { return counts.end(); }
+
+    [[nodiscard]] size_type size() const noexcept { return counts.size(); }
+    [[nodiscard]] bool empty() const noexcept { return counts.empty(); }
+
+    void reserve(size_type count) { counts.reserve(count); }
+    void clear() noexcept { counts.clear(); }
+
+    void swap(hash_counter& other) noexcept { counts.swap(other.counts); }
+};
+
+#endif // HASH_COUNTER_H
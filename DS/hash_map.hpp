@@ -1,6 +1,8 @@
 #ifndef HASH_MAP_H
 #define HASH_MAP_H
 
+#include <bit>
+#include <cstdint>
 #include <vector>
 #include <list>
 #include <functional>
@@ -9,9 +11,21 @@
 #include <utility>
 #include <initializer_list>
 #include <iostream>
-#include <unordered_map>
 #include <memory>
+#include <new>
 #include <string_view>
+#include <span>
+#include <algorithm>
+#include <iterator>
+#include <tuple>
+#include <thread>
+#include <system_error>
+#include <atomic>
+#include <chrono>
+#include <random>
+
+#include "hashers.hpp"
+#include "prefetch.hpp"
 
 template <typename Hash, typename Key>
 concept ValidHasher = requires(Hash h, Key k) {
@@ -26,8 +40,153 @@ concept TransparentEqual = requires(Equal eq, Key k1, Key k2) {
     { eq(s, k) } -> std::convertible_to<bool>;
 } || true);
 
+// Hashers that already spread entropy over all bits declare is_avalanching;
+// their results are masked directly instead of going through the multiply.
+template <typename Hash>
+concept AvalanchingHasher = requires { typename Hash::is_avalanching; };
+
+// Hashers with an h(key, seed) overload, such as string_hash and
+// integer_hash. hash_map passes them its per-instance seed, so keys that
+// collide in one map are unrelated in another.
+template <typename Hash, typename Key>
+concept SeededHasher = requires(const Hash h, const Key& k, std::uint64_t seed) {
+    { h(k, seed) } -> std::convertible_to<std::size_t>;
+};
+
+// Whether entries keep their full hash next to the key, so rehashing never
+// calls the hasher again and chain scans reject mismatches before key_eq.
+// On by default for keys that are not scalars; specialize to override.
+template <typename Key, typename Hash>
+struct hash_map_store_hash : std::bool_constant<!std::is_scalar_v<Key>> {};
+
+// Snapshot returned by hash_map::stats(). The structural fields are computed
+// on demand and always available. The counters are only collected when
+// HASH_MAP_ENABLE_STATS is defined and read zero otherwise.
+struct hash_map_stats {
+    std::size_t size = 0;
+    std::size_t bucket_count = 0;
+    float load_factor = 0.0f;
+    std::size_t empty_buckets = 0;
+    std::size_t max_chain_length = 0;
+    // chain_length_histogram[n] is the number of buckets holding n entries.
+    std::vector<std::size_t> chain_length_histogram;
+    // Bucket array and occupancy bitmap, plus one list node (entry and two
+    // links) per element.
+    std::size_t bytes_allocated = 0;
+
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+    std::uint64_t rehash_count = 0;
+    std::chrono::nanoseconds rehash_time{ 0 };
+
+    // Times a chain outgrew the map's limit and the map switched seeds by
+    // itself; calls to reseed() are not counted. Always counted, and kept
+    // by copies.
+    std::uint64_t reseed_count = 0;
+};
+
+namespace hash_map_impl {
+
+    // Seed for a new map: one random_device draw per process, then a
+    // counter, so constructing a map costs an atomic add and a mix.
+    inline std::uint64_t random_seed() noexcept {
+        static const std::uint64_t process_seed = [] {
+            try {
+                std::random_device device;
+                return (static_cast<std::uint64_t>(device()) << 32) ^ device();
+            }
+            catch (...) {
+                return static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+            }
+        }();
+        static std::atomic<std::uint64_t> counter{ 0 };
+        return mix_integer(process_seed + counter.fetch_add(0x9E3779B97F4A7C15ULL, std::memory_order_relaxed));
+    }
+
+    // Index of the first set bit at or after from in a bitmap of count bits,
+    // or count if there is none. Bits past count must be clear.
+    inline std::size_t next_set_bit(const std::uint64_t* words, std::size_t from, std::size_t count) noexcept {
+        if (from >= count) {
+            return count;
+        }
+        auto word = from / 64;
+        auto bits = words[word] & (~std::uint64_t(0) << (from % 64));
+        const auto last = (count - 1) / 64;
+        while (bits == 0) {
+            if (word == last) {
+                return count;
+            }
+            bits = words[++word];
+        }
+        return word * 64 + static_cast<std::size_t>(std::countr_zero(bits));
+    }
+
+    template <typename F>
+    void for_each_set_bit(const std::uint64_t* words, std::size_t word_count, F&& fn) {
+        for (std::size_t w = 0; w < word_count; ++w) {
+            for (auto bits = words[w]; bits; bits &= bits - 1) {
+                fn(w * 64 + static_cast<std::size_t>(std::countr_zero(bits)));
+            }
+        }
+    }
+
+#ifdef HASH_MAP_ENABLE_STATS
+    // Lookup and rehash counters. Relaxed atomics, so concurrent const
+    // lookups stay race-free. They describe one object: a copy starts at zero.
+    struct map_counters {
+        std::atomic<std::uint64_t> hits{ 0 };
+        std::atomic<std::uint64_t> misses{ 0 };
+        std::atomic<std::uint64_t> rehash_count{ 0 };
+        std::atomic<std::uint64_t> rehash_ns{ 0 };
+
+        map_counters() = default;
+        map_counters(const map_counters&) noexcept {}
+        map_counters& operator=(const map_counters&) noexcept { return *this; }
+
+        void lookup(bool hit) noexcept {
+            (hit ? hits : misses).fetch_add(1, std::memory_order_relaxed);
+        }
+
+        class rehash_timer {
+            map_counters& counters;
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        public:
+            explicit rehash_timer(map_counters& c) noexcept : counters(c) {}
+
+            ~rehash_timer() {
+                const auto elapsed = std::chrono::steady_clock::now() - start;
+                counters.rehash_count.fetch_add(1, std::memory_order_relaxed);
+                counters.rehash_ns.fetch_add(static_cast<std::uint64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()),
+                    std::memory_order_relaxed);
+            }
+        };
+
+        rehash_timer time_rehash() noexcept { return rehash_timer(*this); }
+
+        void fill(hash_map_stats& stats) const noexcept {
+            stats.hits = hits.load(std::memory_order_relaxed);
+            stats.misses = misses.load(std::memory_order_relaxed);
+            stats.rehash_count = rehash_count.load(std::memory_order_relaxed);
+            stats.rehash_time = std::chrono::nanoseconds(rehash_ns.load(std::memory_order_relaxed));
+        }
+    };
+#else
+    // Disabled counters: empty, and every hook compiles away.
+    struct map_counters {
+        struct rehash_timer {};
+
+        void lookup(bool) noexcept {}
+        rehash_timer time_rehash() noexcept { return {}; }
+        void fill(hash_map_stats&) const noexcept {}
+    };
+#endif
+
+} // namespace hash_map_impl
+
 template <typename Key, typename Value,
-    typename Hash = std::hash<Key>,
+    typename Hash = default_hash_t<Key>,
     typename KeyEqual = std::equal_to<>,
     typename Allocator = std::allocator<std::pair<const Key, Value>>>
     requires ValidHasher<Hash, Key>&& TransparentEqual<KeyEqual, Key>
@@ -45,25 +204,296 @@ public:
     using const_reference = const value_type&;
     using pointer = typename std::allocator_traits<Allocator>::pointer;
     using const_pointer = typename std::allocator_traits<Allocator>::const_pointer;
-    using local_iterator = typename std::list<value_type, Allocator>::iterator;
-    using const_local_iterator = typename std::list<value_type, Allocator>::const_iterator;
 
 private:
-    using Bucket = std::list<value_type, Allocator>;
+    static constexpr bool store_hash = hash_map_store_hash<Key, Hash>::value;
+    static constexpr bool seeded_hash = SeededHasher<Hash, Key>;
+
+    struct hashed_entry {
+        value_type value;
+        size_t hash;
+
+        template <typename... Args>
+        explicit hashed_entry(size_t h, Args&&... args)
+            : value(std::forward<Args>(args)...), hash(h) {
+        }
+    };
+
+    using Entry = std::conditional_t<store_hash, hashed_entry, value_type>;
+    using EntryAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Entry>;
+    using Bucket = std::list<Entry, EntryAllocator>;
+
+public:
+    using local_iterator = typename Bucket::iterator;
+    using const_local_iterator = typename Bucket::const_iterator;
+
+private:
     std::vector<Bucket> buckets;
+    // One bit per bucket, set while the bucket is non-empty, so iteration and
+    // clear() skip empty buckets 64 at a time.
+    std::vector<std::uint64_t> occupied;
     Hash hash_fn;
     KeyEqual key_eq;
     [[no_unique_address]] Allocator alloc;
     float max_load_factor_ = 0.75f;
+    float min_load_factor_ = 0.0f;
     size_type element_count = 0;
+    [[no_unique_address]] hash_map_impl::map_counters counters;
+    std::uint64_t seed_ = hash_map_impl::random_seed();
+    size_type next_reseed_size = 0;
+    std::uint64_t reseed_count_ = 0;
+
+    // Every bucket list is built from the map's allocator, so all of them
+    // compare equal and nodes can be spliced between them on rehash.
+    static std::vector<Bucket> make_buckets(size_type count, const Allocator& a) {
+        const EntryAllocator entry_alloc(a);
+        std::vector<Bucket> result;
+        result.reserve(count);
+        for (size_type i = 0; i < count; ++i) {
+            result.emplace_back(entry_alloc);
+        }
+        return result;
+    }
+
+    static size_type occupancy_words(size_type bucket_count) noexcept {
+        return (bucket_count + 63) / 64;
+    }
+
+    void mark_occupied(const Bucket& bucket) noexcept {
+        const auto idx = static_cast<size_type>(&bucket - buckets.data());
+        occupied[idx / 64] |= std::uint64_t(1) << (idx % 64);
+    }
+
+    void mark_if_empty(const Bucket& bucket) noexcept {
+        if (bucket.empty()) {
+            const auto idx = static_cast<size_type>(&bucket - buckets.data());
+            occupied[idx / 64] &= ~(std::uint64_t(1) << (idx % 64));
+        }
+    }
+
+    // Bucket counts are powers of two, so the index is taken from the hash
+    // without a division: masked for avalanching hashers that already took
+    // the seed, otherwise the top bits of a Fibonacci multiply of hash ^ seed,
+    // which also mixes identity hashes.
+    static size_type normalize_bucket_count(size_type count) noexcept {
+        return std::bit_ceil(count < 2 ? size_type(2) : count);
+    }
+
+    size_type bucket_index(size_t hash) const noexcept {
+        if constexpr (AvalanchingHasher<Hash> && seeded_hash) {
+            return hash & (buckets.size() - 1);
+        }
+        else {
+            const auto shift = 64 - std::countr_zero(buckets.size());
+            return static_cast<size_type>(((static_cast<std::uint64_t>(hash) ^ seed_) * 0x9E3779B97F4A7C15ULL) >> shift);
+        }
+    }
+
+    template <typename K>
+    size_t hash_of(const K& key) const noexcept {
+        if constexpr (seeded_hash) {
+            return hash_fn(key, seed_);
+        }
+        else {
+            return hash_fn(key);
+        }
+    }
+
+    // With a working hash, chains are Poisson distributed with mean
+    // load_factor(): at a load of 1, a chain over 16 turns up in about one
+    // of 10^14 buckets. Anything longer means keys that collide under this
+    // seed, by accident or by design.
+    size_type chain_limit() const noexcept {
+        return 16 + static_cast<size_type>(2 * max_load_factor_);
+    }
+
+    bool chain_too_long(const Bucket& bucket) const noexcept {
+        return bucket.size() > chain_limit() && element_count >= next_reseed_size;
+    }
+
+    // Moves to a fresh seed. Keys whose unseeded hashes are equal stay
+    // together under every seed, so the next reseed waits until the map has
+    // doubled: an adversary gets at most one O(n) rebuild per doubling.
+    void reseed_after_collisions() {
+        reseed(hash_map_impl::random_seed());
+        ++reseed_count_;
+        next_reseed_size = element_count * 2;
+    }
+
+    // Keys of another type are hashed and compared as-is only when both
+    // Hash and KeyEqual are transparent; otherwise they are converted once.
+    template <typename K>
+    static constexpr bool is_heterogeneous_v = std::is_same_v<K, key_type> ||
+        (Transparent<Hash> && Transparent<KeyEqual>);
+
+    static value_type& entry_value(Entry& entry) noexcept {
+        if constexpr (store_hash) {
+            return entry.value;
+        }
+        else {
+            return entry;
+        }
+    }
+
+    static const value_type& entry_value(const Entry& entry) noexcept {
+        if constexpr (store_hash) {
+            return entry.value;
+        }
+        else {
+            return entry;
+        }
+    }
+
+    size_t entry_hash(const Entry& entry) const noexcept {
+        if constexpr (store_hash) {
+            return entry.hash;
+        }
+        else {
+            return hash_of(entry.first);
+        }
+    }
+
+    template <typename K>
+    bool entry_matches(const Entry& entry, size_t hash, const K& key) const noexcept {
+        if constexpr (store_hash) {
+            return entry.hash == hash && key_eq(entry.value.first, key);
+        }
+        else {
+            return key_eq(entry.first, key);
+        }
+    }
+
+    template <typename K>
+    typename Bucket::iterator find_in_bucket(Bucket& bucket, size_t hash, const K& key) noexcept {
+        auto it = bucket.begin();
+        while (it != bucket.end() && !entry_matches(*it, hash, key)) {
+            ++it;
+        }
+        return it;
+    }
+
+    template <typename... Args>
+    typename Bucket::iterator emplace_entry(Bucket& bucket, size_t hash, Args&&... args) {
+        if constexpr (store_hash) {
+            bucket.emplace_back(hash, std::forward<Args>(args)...);
+        }
+        else {
+            bucket.emplace_back(std::forward<Args>(args)...);
+        }
+        mark_occupied(bucket);
+        return std::prev(bucket.end());
+    }
+
+    // List nodes can only be spliced between lists whose allocators compare
+    // equal, as with std::list::splice.
+    bool shares_nodes_with(const Allocator& other) const noexcept {
+        if constexpr (std::allocator_traits<Allocator>::is_always_equal::value) {
+            return true;
+        }
+        else {
+            return alloc == other;
+        }
+    }
+
+    // Rebuilds an entry owned by another allocator in a node of this map's
+    // own. The source node is about to be destroyed, so its key is moved
+    // from when that cannot throw and copied otherwise, which leaves it
+    // intact if the copy fails.
+    typename Bucket::iterator move_entry(Bucket& bucket, size_t hash, Entry& from) {
+        auto& value = entry_value(from);
+        return emplace_entry(bucket, hash,
+            std::move_if_noexcept(const_cast<Key&>(value.first)), std::move_if_noexcept(value.second));
+    }
+
+    // Resolves keys a block at a time: all keys of a block are hashed and
+    // their buckets prefetched, then their first nodes, and only then are
+    // the chains walked, so the misses of one block overlap.
+    template <typename K, typename Out>
+    size_type resolve_batch(std::span<K> keys, Out&& out) noexcept {
+        using key_arg = std::remove_const_t<K>;
+        size_type found = 0;
+
+        if constexpr (!is_heterogeneous_v<key_arg>) {
+            for (size_type i = 0; i < keys.size(); ++i) {
+                auto* value = find(keys[i]);
+                found += value != nullptr;
+                out(i, value);
+            }
+        }
+        else {
+            constexpr size_type block = 16;
+            size_t hashes[block];
+            Bucket* slots[block];
+
+            for (size_type base = 0; base < keys.size(); base += block) {
+                const auto n = std::min(block, keys.size() - base);
+                for (size_type i = 0; i < n; ++i) {
+                    hashes[i] = hash_of(keys[base + i]);
+                    slots[i] = &buckets[bucket_index(hashes[i])];
+                    hash_map_impl::prefetch(slots[i]);
+                }
+                for (size_type i = 0; i < n; ++i) {
+                    if (!slots[i]->empty()) {
+                        hash_map_impl::prefetch(&slots[i]->front());
+                    }
+                }
+                for (size_type i = 0; i < n; ++i) {
+                    auto it = find_in_bucket(*slots[i], hashes[i], keys[base + i]);
+                    Value* value = it != slots[i]->end() ? &entry_value(*it).second : nullptr;
+                    counters.lookup(value != nullptr);
+                    found += value != nullptr;
+                    out(base + i, value);
+                }
+            }
+        }
+        return found;
+    }
 
-    size_type get_bucket(const key_type& key) const noexcept {
-        return hash_fn(key) % buckets.size();
+    static constexpr size_type parallel_rehash_threshold = 1 << 16;
+
+    size_type buckets_for(size_type count) const noexcept {
+        return static_cast<size_type>(static_cast<double>(count) / max_load_factor_) + 1;
     }
 
-    void rehash_if_needed() {
+    // Runs fn(0) .. fn(workers - 1), each on its own thread where one can be
+    // started; indices whose thread could not be started run on the caller.
+    template <typename F>
+    static void parallel_for(size_type workers, F&& fn) {
+        std::vector<std::jthread> pool;
+        pool.reserve(workers - 1);
+        size_type started = 1;
+        try {
+            for (; started < workers; ++started) {
+                pool.emplace_back(fn, started);
+            }
+        }
+        catch (const std::system_error&) {
+        }
+        for (auto w = started; w < workers; ++w) {
+            fn(w);
+        }
+        fn(0);
+    }
+
+    // Sized for element_count rather than doubled, so a batch that added
+    // many keys since the last check is back under the limit in one rehash.
+    bool rehash_if_needed() {
         if (load_factor() > max_load_factor_) {
-            rehash(buckets.size() * 2);
+            rehash(buckets_for(element_count));
+            return true;
+        }
+        return false;
+    }
+
+    // Shrinking only saves memory, so a failed allocation keeps the table
+    // as it is; erase stays noexcept.
+    void shrink_if_needed() noexcept {
+        if (static_cast<float>(element_count) < min_load_factor_ * buckets.size()) {
+            try {
+                shrink_to_fit();
+            }
+            catch (const std::bad_alloc&) {
+            }
         }
     }
 
@@ -79,16 +509,20 @@ public:
             typename std::vector<Bucket>::const_iterator,
             typename std::vector<Bucket>::iterator>;
 
-        VectorIterator vec_it;
-        VectorIterator vec_end;
+        VectorIterator first;
+        const std::uint64_t* occupied = nullptr;
+        size_type index = 0;
+        size_type count = 0;
         BucketIterator bucket_it;
 
-        void skip_empty_buckets() {
-            while (vec_it != vec_end && bucket_it == vec_it->end()) {
-                ++vec_it;
-                if (vec_it != vec_end) {
-                    bucket_it = vec_it->begin();
-                }
+        template <bool> friend class Iterator;
+
+        // Jumps to the first non-empty bucket at or after from, using the
+        // map's occupancy bitmap rather than testing each bucket.
+        void seek(size_type from) {
+            index = hash_map_impl::next_set_bit(occupied, from, count);
+            if (index != count) {
+                bucket_it = first[index].begin();
             }
         }
 
@@ -99,21 +533,27 @@ public:
         using pointer = std::conditional_t<IsConst, const value_type*, value_type*>;
         using reference = std::conditional_t<IsConst, const value_type&, value_type&>;
 
-        Iterator(VectorIterator begin, VectorIterator end)
-            : vec_it(begin), vec_end(end) {
-            if (vec_it != vec_end) {
-                bucket_it = vec_it->begin();
-                skip_empty_buckets();
-            }
+        Iterator() = default;
+
+        Iterator(VectorIterator first, const std::uint64_t* occupied, size_type count, size_type from)
+            : first(first), occupied(occupied), count(count) {
+            seek(from);
         }
 
-        Iterator(VectorIterator vec, Bucket& b, BucketIterator bit)
-            : vec_it(vec), vec_end(vec + 1), bucket_it(bit) {
+        Iterator(VectorIterator first, const std::uint64_t* occupied, size_type count, size_type index, BucketIterator bit)
+            : first(first), occupied(occupied), index(index), count(count), bucket_it(bit) {
+        }
+
+        template <bool WasConst>
+            requires (IsConst && !WasConst)
+        Iterator(const Iterator<WasConst>& other)
+            : first(other.first), occupied(other.occupied), index(other.index), count(other.count), bucket_it(other.bucket_it) {
         }
 
         Iterator& operator++() {
-            ++bucket_it;
-            skip_empty_buckets();
+            if (++bucket_it == first[index].end()) {
+                seek(index + 1);
+            }
             return *this;
         }
 
@@ -123,12 +563,12 @@ public:
             return tmp;
         }
 
-        reference operator*() const { return *bucket_it; }
-        pointer operator->() const { return &(*bucket_it); }
+        reference operator*() const { return entry_value(*bucket_it); }
+        pointer operator->() const { return &entry_value(*bucket_it); }
 
         bool operator==(const Iterator& other) const {
-            return vec_it == other.vec_it &&
-                (vec_it == vec_end || bucket_it == other.bucket_it);
+            return index == other.index &&
+                (index == count || bucket_it == other.bucket_it);
         }
 
         bool operator!=(const Iterator& other) const {
@@ -139,11 +579,54 @@ public:
     using iterator = Iterator<false>;
     using const_iterator = Iterator<true>;
 
+private:
+    iterator iterator_at(size_type bucket_idx, typename Bucket::iterator it) noexcept {
+        return iterator(buckets.begin(), occupied.data(), buckets.size(), bucket_idx, it);
+    }
+
+public:
+
+    // Owns one entry detached from a map. The entry stays in its original
+    // list node, held by a single-element bucket, so moving it between maps
+    // with extract and insert never allocates. Between maps whose allocators
+    // compare unequal, insert moves the entry into a node of its own instead.
+    class node_type {
+        Bucket node;
+        // Seed the stored hash was computed under.
+        std::uint64_t seed = 0;
+
+        friend class hash_map;
+
+        explicit node_type(const Allocator& a) : node(EntryAllocator(a)) {
+        }
+
+    public:
+        node_type() = default;
+        node_type(node_type&&) noexcept = default;
+        node_type& operator=(node_type&&) noexcept = default;
+
+        [[nodiscard]] bool empty() const noexcept { return node.empty(); }
+        explicit operator bool() const noexcept { return !node.empty(); }
+
+        [[nodiscard]] const key_type& key() const { return entry_value(node.front()).first; }
+        [[nodiscard]] mapped_type& mapped() const { return const_cast<mapped_type&>(entry_value(node.front()).second); }
+
+        [[nodiscard]] allocator_type get_allocator() const { return allocator_type(node.get_allocator()); }
+    };
+
+    struct insert_return_type {
+        iterator position;
+        bool inserted;
+        node_type node;
+    };
+
     explicit hash_map(size_type bucket_count = 16,
         const Hash& hash = Hash(),
         const KeyEqual& equal = KeyEqual(),
         const Allocator& alloc = Allocator())
-        : buckets(bucket_count), hash_fn(hash), key_eq(equal), alloc(alloc) {
+        : buckets(make_buckets(normalize_bucket_count(bucket_count), alloc)),
+        occupied(occupancy_words(buckets.size())),
+        hash_fn(hash), key_eq(equal), alloc(alloc) {
     }
 
     hash_map(std::initializer_list<value_type> init,
@@ -152,32 +635,60 @@ public:
         const KeyEqual& equal = KeyEqual(),
         const Allocator& alloc = Allocator())
         : hash_map(bucket_count, hash, equal, alloc) {
-        for (const auto& pair : init) {
-            insert(pair.first, pair.second);
-        }
+        insert(init.begin(), init.end());
+    }
+
+    template <std::input_iterator It>
+        requires requires (It it) { it->first; it->second; }
+    hash_map(It first, It last,
+        size_type bucket_count = 16,
+        const Hash& hash = Hash(),
+        const KeyEqual& equal = KeyEqual(),
+        const Allocator& alloc = Allocator())
+        : hash_map(bucket_count, hash, equal, alloc) {
+        insert(first, last);
+    }
+
+    explicit hash_map(std::span<const value_type> items,
+        size_type bucket_count = 16,
+        const Hash& hash = Hash(),
+        const KeyEqual& equal = KeyEqual(),
+        const Allocator& alloc = Allocator())
+        : hash_map(bucket_count, hash, equal, alloc) {
+        insert(items.begin(), items.end());
     }
 
     hash_map(const hash_map& other)
-        : buckets(other.buckets.size()),
+        : occupied(other.occupied),
         hash_fn(other.hash_fn),
         key_eq(other.key_eq),
         alloc(std::allocator_traits<Allocator>::select_on_container_copy_construction(other.alloc)),
         max_load_factor_(other.max_load_factor_),
-        element_count(0) {
-        for (const auto& bucket : other.buckets) {
-            for (const auto& pair : bucket) {
-                insert(pair.first, pair.second);
-            }
+        min_load_factor_(other.min_load_factor_),
+        element_count(other.element_count),
+        seed_(other.seed_),
+        next_reseed_size(other.next_reseed_size),
+        reseed_count_(other.reseed_count_) {
+        // Clones the bucket layout entry by entry under the same seed: nothing
+        // is rehashed or compared, and the load factor is already within bounds.
+        buckets = make_buckets(other.buckets.size(), alloc);
+        for (size_type i = 0; i < buckets.size(); ++i) {
+            buckets[i].insert(buckets[i].end(), other.buckets[i].begin(), other.buckets[i].end());
         }
     }
 
     hash_map(hash_map&& other) noexcept
         : buckets(std::move(other.buckets)),
+        occupied(std::move(other.occupied)),
         hash_fn(std::move(other.hash_fn)),
         key_eq(std::move(other.key_eq)),
         alloc(std::move(other.alloc)),
         max_load_factor_(other.max_load_factor_),
-        element_count(other.element_count) {
+        min_load_factor_(other.min_load_factor_),
+        element_count(other.element_count),
+        seed_(other.seed_),
+        next_reseed_size(other.next_reseed_size),
+        reseed_count_(other.reseed_count_) {
         other.element_count = 0;
     }
 
@@ -191,48 +702,54 @@ public:
     void swap(hash_map& other) noexcept {
         using std::swap;
         swap(buckets, other.buckets);
+        swap(occupied, other.occupied);
         swap(hash_fn, other.hash_fn);
         swap(key_eq, other.key_eq);
         swap(alloc, other.alloc);
         swap(max_load_factor_, other.max_load_factor_);
+        swap(min_load_factor_, other.min_load_factor_);
         swap(element_count, other.element_count);
+        swap(seed_, other.seed_);
+        swap(next_reseed_size, other.next_reseed_size);
+        swap(reseed_count_, other.reseed_count_);
     }
 
     [[nodiscard]] iterator begin() noexcept {
-        return iterator(buckets.begin(), buckets.end());
+        return iterator(buckets.begin(), occupied.data(), buckets.size(), 0);
     }
 
     [[nodiscard]] const_iterator begin() const noexcept {
-        return const_iterator(buckets.begin(), buckets.end());
+        return const_iterator(buckets.begin(), occupied.data(), buckets.size(), 0);
     }
 
     [[nodiscard]] const_iterator cbegin() const noexcept {
-        return const_iterator(buckets.begin(), buckets.end());
+        return begin();
     }
 
     [[nodiscard]] iterator end() noexcept {
-        return iterator(buckets.end(), buckets.end());
+        return iterator(buckets.begin(), occupied.data(), buckets.size(), buckets.size());
     }
 
     [[nodiscard]] const_iterator end() const noexcept {
-        return const_iterator(buckets.end(), buckets.end());
+        return const_iterator(buckets.begin(), occupied.data(), buckets.size(), buckets.size());
     }
 
     [[nodiscard]] const_iterator cend() const noexcept {
-        return const_iterator(buckets.end(), buckets.end());
+        return end();
     }
 
     template <typename K>
     [[nodiscard]] Value* find(const K& key) noexcept {
-        auto bucket_idx = get_bucket(key);
-        auto& bucket = buckets[bucket_idx];
-
-        for (auto& item : bucket) {
-            if (key_eq(item.first, key)) {
-                return &item.second;
-            }
+        if constexpr (!is_heterogeneous_v<K>) {
+            return find(Key(key));
+        }
+        else {
+            auto hash = hash_of(key);
+            auto& bucket = buckets[bucket_index(hash)];
+            auto it = find_in_bucket(bucket, hash, key);
+            counters.lookup(it != bucket.end());
+            return it != bucket.end() ? &entry_value(*it).second : nullptr;
         }
-        return nullptr;
     }
 
     template <typename K>
@@ -240,62 +757,370 @@ public:
         return const_cast<hash_map*>(this)->find(key);
     }
 
+    // Batched find: results[i] receives find(keys[i]). results must be at
+    // least as long as keys. Returns the number of keys found.
+    template <typename K, std::size_t Extent>
+    size_type find_batch(std::span<K, Extent> keys, std::span<Value*> results) noexcept {
+        return resolve_batch(std::span<K>(keys), [&](size_type i, Value* value) { results[i] = value; });
+    }
+
+    template <typename K, std::size_t Extent>
+    size_type find_batch(std::span<K, Extent> keys, std::span<const Value*> results) const noexcept {
+        return const_cast<hash_map*>(this)->resolve_batch(std::span<K>(keys),
+            [&](size_type i, const Value* value) { results[i] = value; });
+    }
+
+    template <typename K, std::size_t Extent>
+    size_type contains_batch(std::span<K, Extent> keys, std::span<bool> results) const noexcept {
+        return const_cast<hash_map*>(this)->resolve_batch(std::span<K>(keys),
+            [&](size_type i, const Value* value) { results[i] = value != nullptr; });
+    }
+
+    // Batched operator[]: calls fn(i, value) with the mapped value of
+    // keys[i], value-initialized if the key was absent. Blocks are hashed and
+    // prefetched as in find_batch; the table grows only between blocks, so
+    // repeated keys never make it reserve for more entries than it gets.
+    template <typename K, std::size_t Extent, typename F>
+    void update_batch(std::span<K, Extent> keys, F&& fn) {
+        using key_arg = std::remove_const_t<K>;
+
+        if constexpr (!is_heterogeneous_v<key_arg>) {
+            for (size_type i = 0; i < keys.size(); ++i) {
+                fn(i, (*this)[keys[i]]);
+            }
+        }
+        else {
+            constexpr size_type block = 16;
+            size_t hashes[block];
+            Bucket* slots[block];
+
+            for (size_type base = 0; base < keys.size(); base += block) {
+                const auto n = std::min(block, keys.size() - base);
+                for (size_type i = 0; i < n; ++i) {
+                    hashes[i] = hash_of(keys[base + i]);
+                    slots[i] = &buckets[bucket_index(hashes[i])];
+                    hash_map_impl::prefetch(slots[i]);
+                }
+                for (size_type i = 0; i < n; ++i) {
+                    if (!slots[i]->empty()) {
+                        hash_map_impl::prefetch(&slots[i]->front());
+                    }
+                }
+                bool long_chain = false;
+                for (size_type i = 0; i < n; ++i) {
+                    auto& bucket = *slots[i];
+                    auto it = find_in_bucket(bucket, hashes[i], keys[base + i]);
+                    counters.lookup(it != bucket.end());
+                    if (it == bucket.end()) {
+                        it = emplace_entry(bucket, hashes[i], std::piecewise_construct,
+                            std::forward_as_tuple(keys[base + i]), std::forward_as_tuple());
+                        ++element_count;
+                        long_chain = long_chain || chain_too_long(bucket);
+                    }
+                    fn(base + i, entry_value(*it).second);
+                }
+                if (long_chain) {
+                    reseed_after_collisions();
+                }
+                rehash_if_needed();
+            }
+        }
+    }
+
     template <typename K>
     Value& operator[](K&& key) {
-        if (auto* val = find(key)) {
-            return *val;
+        if constexpr (!is_heterogeneous_v<std::remove_cvref_t<K>>) {
+            return (*this)[Key(std::forward<K>(key))];
         }
+        else {
+            auto hash = hash_of(key);
+            auto& bucket = buckets[bucket_index(hash)];
+            auto it = find_in_bucket(bucket, hash, key);
+            counters.lookup(it != bucket.end());
+            if (it != bucket.end()) {
+                return entry_value(*it).second;
+            }
 
-        auto bucket_idx = get_bucket(key);
-        auto& bucket = buckets[bucket_idx];
-        bucket.emplace_back(std::forward<K>(key), Value());
-        ++element_count;
-        rehash_if_needed();
-        return bucket.back().second;
+            auto& value = entry_value(*emplace_entry(bucket, hash, std::forward<K>(key), Value())).second;
+            ++element_count;
+            if (chain_too_long(bucket)) {
+                reseed_after_collisions();
+            }
+            rehash_if_needed();
+            return value;
+        }
     }
 
     template <typename K, typename V>
+        requires std::constructible_from<Key, K>
     std::pair<iterator, bool> insert(K&& key, V&& value) {
-        auto bucket_idx = get_bucket(key);
-        auto& bucket = buckets[bucket_idx];
+        return try_emplace(std::forward<K>(key), std::forward<V>(value));
+    }
+
+    // Constructs the value from args only if the key is absent; otherwise
+    // neither the key nor args are touched. One hash, one chain walk.
+    template <typename K, typename... Args>
+        requires std::constructible_from<Key, K>
+    std::pair<iterator, bool> try_emplace(K&& key, Args&&... args) {
+        if constexpr (!is_heterogeneous_v<std::remove_cvref_t<K>>) {
+            return try_emplace(Key(std::forward<K>(key)), std::forward<Args>(args)...);
+        }
+        else {
+            auto hash = hash_of(key);
+            auto bucket_idx = bucket_index(hash);
+            auto& bucket = buckets[bucket_idx];
+
+            auto it = find_in_bucket(bucket, hash, key);
+            counters.lookup(it != bucket.end());
+            if (it != bucket.end()) {
+                return { iterator_at(bucket_idx, it), false };
+            }
+
+            auto node = emplace_entry(bucket, hash, std::piecewise_construct,
+                std::forward_as_tuple(std::forward<K>(key)),
+                std::forward_as_tuple(std::forward<Args>(args)...));
+            ++element_count;
+            bool moved = false;
+            if (chain_too_long(bucket)) {
+                reseed_after_collisions();
+                moved = true;
+            }
+            if (rehash_if_needed() || moved) {
+                bucket_idx = bucket_index(entry_hash(*node));
+            }
+            return { iterator_at(bucket_idx, node), true };
+        }
+    }
+
+    template <typename K, typename V>
+        requires std::constructible_from<Key, K>
+    std::pair<iterator, bool> emplace(K&& key, V&& value) {
+        return try_emplace(std::forward<K>(key), std::forward<V>(value));
+    }
+
+    // The key is built from key_args up front, since it has to be hashed;
+    // the value is only constructed if that key is absent.
+    template <typename... KeyArgs, typename... ValueArgs>
+    std::pair<iterator, bool> emplace(std::piecewise_construct_t,
+        std::tuple<KeyArgs...> key_args, std::tuple<ValueArgs...> value_args) {
+        return std::apply([&](auto&&... args) {
+            return try_emplace(std::make_from_tuple<Key>(std::move(key_args)),
+                std::forward<decltype(args)>(args)...);
+        }, std::move(value_args));
+    }
+
+    // Inserts the pair, or assigns value to the existing entry. The bool is
+    // true if a new entry was created.
+    template <typename K, typename V>
+        requires std::constructible_from<Key, K>
+    std::pair<iterator, bool> insert_or_assign(K&& key, V&& value) {
+        // try_emplace leaves value untouched when the key exists, so it is
+        // still there to assign from.
+        auto result = try_emplace(std::forward<K>(key), std::forward<V>(value));
+        if (!result.second) {
+            (*result.first).second = std::forward<V>(value);
+        }
+        return result;
+    }
+
+    // Update in place: calls fn(Value&) on the existing value, or on a
+    // value-initialized one inserted for the key, and returns what fn returns.
+    template <typename K, typename F>
+        requires std::constructible_from<Key, K>
+    decltype(auto) compute(K&& key, F&& fn) {
+        auto& value = (*try_emplace(std::forward<K>(key)).first).second;
+        return std::invoke(std::forward<F>(fn), value);
+    }
+
+    // Bulk insert. A forward range is sized for with a single reserve, then
+    // placed a block at a time: the keys of a block are hashed in one tight
+    // pass with their buckets prefetched, and the entries are linked in with
+    // no rehash in between. Keys already present are left untouched.
+    template <std::input_iterator It>
+        requires requires (It it) { it->first; it->second; }
+    void insert(It first, It last) {
+        using key_arg = std::remove_cvref_t<decltype(first->first)>;
+
+        if constexpr (std::forward_iterator<It> && is_heterogeneous_v<key_arg>) {
+            reserve(element_count + static_cast<size_type>(std::distance(first, last)));
+
+            constexpr size_type block = 64;
+            size_t hashes[block];
+            bool long_chain = false;
+            while (first != last) {
+                auto block_first = first;
+                size_type n = 0;
+                for (; n < block && first != last; ++n, ++first) {
+                    hashes[n] = hash_of(first->first);
+                    hash_map_impl::prefetch(&buckets[bucket_index(hashes[n])]);
+                }
+                for (size_type i = 0; i < n; ++i, ++block_first) {
+                    auto& bucket = buckets[bucket_index(hashes[i])];
+                    if (find_in_bucket(bucket, hashes[i], block_first->first) == bucket.end()) {
+                        emplace_entry(bucket, hashes[i], block_first->first, block_first->second);
+                        ++element_count;
+                        long_chain = long_chain || chain_too_long(bucket);
+                    }
+                }
+            }
+            // Checked once at the end, since a reseed would invalidate the
+            // hashes of a block in flight.
+            if (long_chain) {
+                reseed_after_collisions();
+            }
+        }
+        else {
+            for (; first != last; ++first) {
+                insert(first->first, first->second);
+            }
+        }
+    }
 
-        for (auto it = bucket.begin(); it != bucket.end(); ++it) {
-            if (key_eq(it->first, key)) {
-                return { iterator(buckets.begin() + bucket_idx, bucket, it), false };
+    // Unlinks the entry for key into a node handle, or returns an empty one.
+    template <typename K>
+    node_type extract(const K& key) {
+        if constexpr (!is_heterogeneous_v<K>) {
+            return extract(Key(key));
+        }
+        else {
+            node_type handle(alloc);
+            handle.seed = seed_;
+            auto hash = hash_of(key);
+            auto& bucket = buckets[bucket_index(hash)];
+            if (auto it = find_in_bucket(bucket, hash, key); it != bucket.end()) {
+                handle.node.splice(handle.node.end(), bucket, it);
+                mark_if_empty(bucket);
+                --element_count;
+                shrink_if_needed();
             }
+            return handle;
+        }
+    }
+
+    // Links the handle's node in unless its key is already present, in which
+    // case the node is handed back in the result. The handle remembers the
+    // seed of the map it came from; its stored hash is reused when that
+    // matches this map's seed and recomputed otherwise.
+    insert_return_type insert(node_type&& handle) {
+        if (handle.empty()) {
+            return { end(), false, node_type(alloc) };
         }
 
-        bucket.emplace_back(std::forward<K>(key), std::forward<V>(value));
+        auto node = handle.node.begin();
+        if constexpr (seeded_hash && store_hash) {
+            if (handle.seed != seed_) {
+                node->hash = hash_of(node->value.first);
+                handle.seed = seed_;
+            }
+        }
+        auto hash = entry_hash(*node);
+        auto bucket_idx = bucket_index(hash);
+        auto& bucket = buckets[bucket_idx];
+        if (auto it = find_in_bucket(bucket, hash, entry_value(*node).first); it != bucket.end()) {
+            return { iterator_at(bucket_idx, it), false, std::move(handle) };
+        }
+
+        if (shares_nodes_with(handle.get_allocator())) {
+            bucket.splice(bucket.end(), handle.node, node);
+            mark_occupied(bucket);
+        }
+        else {
+            node = move_entry(bucket, hash, *node);
+            handle.node.clear();
+        }
         ++element_count;
-        rehash_if_needed();
-        return { iterator(buckets.begin() + bucket_idx, bucket, std::prev(bucket.end())), true };
+        bool moved = false;
+        if (chain_too_long(bucket)) {
+            reseed_after_collisions();
+            moved = true;
+        }
+        if (rehash_if_needed() || moved) {
+            bucket_idx = bucket_index(entry_hash(*node));
+        }
+        return { iterator_at(bucket_idx, node), true, node_type(alloc) };
+    }
+
+    // Moves every entry of source whose key is not present here, node by
+    // node; entries with duplicate keys stay in source. If the allocators
+    // compare unequal, each entry is moved into a new node instead.
+    void merge(hash_map& source) {
+        if (&source == this) {
+            return;
+        }
+        reserve(element_count + source.element_count);
+        const bool rehash_keys = seeded_hash && source.seed_ != seed_;
+        const bool splice = shares_nodes_with(source.alloc);
+        bool long_chain = false;
+        for (auto& from : source.buckets) {
+            for (auto it = from.begin(); it != from.end();) {
+                auto next = std::next(it);
+                auto hash = rehash_keys ? hash_of(entry_value(*it).first) : entry_hash(*it);
+                auto& bucket = buckets[bucket_index(hash)];
+                if (find_in_bucket(bucket, hash, entry_value(*it).first) == bucket.end()) {
+                    if (splice) {
+                        if constexpr (store_hash) {
+                            it->hash = hash;
+                        }
+                        bucket.splice(bucket.end(), from, it);
+                        mark_occupied(bucket);
+                    }
+                    else {
+                        move_entry(bucket, hash, *it);
+                        from.erase(it);
+                    }
+                    ++element_count;
+                    --source.element_count;
+                    long_chain = long_chain || chain_too_long(bucket);
+                }
+                it = next;
+            }
+            source.mark_if_empty(from);
+        }
+        if (long_chain) {
+            reseed_after_collisions();
+        }
+        source.shrink_if_needed();
+    }
+
+    void merge(hash_map&& source) {
+        merge(source);
     }
 
     template <typename K>
     size_type erase(const K& key) noexcept {
-        auto bucket_idx = get_bucket(key);
-        auto& bucket = buckets[bucket_idx];
+        if constexpr (!is_heterogeneous_v<K>) {
+            return erase(Key(key));
+        }
+        else {
+            auto hash = hash_of(key);
+            auto& bucket = buckets[bucket_index(hash)];
 
-        for (auto it = bucket.begin(); it != bucket.end(); ++it) {
-            if (key_eq(it->first, key)) {
+            if (auto it = find_in_bucket(bucket, hash, key); it != bucket.end()) {
                 bucket.erase(it);
+                mark_if_empty(bucket);
                 --element_count;
+                shrink_if_needed();
                 return 1;
             }
+            return 0;
         }
-        return 0;
     }
 
+    // Visits only the occupied buckets. Keeps the bucket array for reuse
+    // unless min_load_factor() is set.
     void clear() noexcept {
-        for (auto& bucket : buckets) {
-            bucket.clear();
-        }
+        hash_map_impl::for_each_set_bit(occupied.data(), occupied.size(), [&](size_type i) {
+            buckets[i].clear();
+        });
+        std::fill(occupied.begin(), occupied.end(), 0);
         element_count = 0;
+        shrink_if_needed();
     }
 
     [[nodiscard]] size_type size() const noexcept { return element_count; }
     [[nodiscard]] bool empty() const noexcept { return element_count == 0; }
     [[nodiscard]] size_type bucket_count() const noexcept { return buckets.size(); }
+    [[nodiscard]] allocator_type get_allocator() const noexcept { return alloc; }
     [[nodiscard]] size_type bucket_size(size_type n) const { return buckets[n].size(); }
 
     [[nodiscard]] float load_factor() const noexcept {
@@ -308,23 +1133,152 @@ public:
 
     void max_load_factor(float ml) {
         max_load_factor_ = ml;
+        min_load_factor_ = std::min(min_load_factor_, ml / 4);
         rehash_if_needed();
     }
 
+    [[nodiscard]] float min_load_factor() const noexcept {
+        return min_load_factor_;
+    }
+
+    // 0, the default, never shrinks the table. Above 0, an erase, extract or
+    // clear() that leaves load_factor() below ml shrinks it as shrink_to_fit()
+    // does, invalidating iterators like any rehash. Capped at a quarter of
+    // max_load_factor(), so a table that has just grown or shrunk takes
+    // O(size()) operations before it resizes again.
+    void min_load_factor(float ml) {
+        min_load_factor_ = std::min(ml, max_load_factor_ / 4);
+        shrink_if_needed();
+    }
+
+    // Rebuilds the table with the bucket count reserve(size()) would pick on
+    // an empty map, if that is smaller than the current one.
+    void shrink_to_fit() {
+        if (auto needed = normalize_bucket_count(buckets_for(element_count)); needed < buckets.size()) {
+            rehash(needed);
+        }
+    }
+
+    // Grows the table so that count elements fit without a rehash.
+    void reserve(size_type count) {
+        if (auto needed = buckets_for(count); needed > buckets.size()) {
+            rehash(needed);
+        }
+    }
+
+    void reserve_parallel(size_type count, unsigned threads = std::thread::hardware_concurrency()) {
+        if (auto needed = buckets_for(count); needed > buckets.size()) {
+            rehash_parallel(needed, threads);
+        }
+    }
+
+    [[nodiscard]] std::uint64_t seed() const noexcept { return seed_; }
+
+    // Switches to another hash seed and rebuilds the table around it. The
+    // map also does this by itself when a chain grows past what a working
+    // hash would produce; call it directly to pin a seed for reproducible
+    // layouts.
+    void reseed(std::uint64_t new_seed) {
+        seed_ = new_seed;
+        if constexpr (seeded_hash && store_hash) {
+            for (auto& bucket : buckets) {
+                for (auto& entry : bucket) {
+                    entry.hash = hash_of(entry.value.first);
+                }
+            }
+        }
+        rehash(buckets.size());
+    }
+
+    // The hash the map uses for key, seed included; what print_by_hash expects.
+    template <typename K>
+    [[nodiscard]] size_t key_hash(const K& key) const noexcept {
+        if constexpr (!is_heterogeneous_v<K>) {
+            return key_hash(Key(key));
+        }
+        else {
+            return hash_of(key);
+        }
+    }
+
     void rehash(size_type count) {
-        std::vector<Bucket> new_buckets(count);
-        for (auto& bucket : buckets) {
+        [[maybe_unused]] auto timer = counters.time_rehash();
+        auto old_buckets = make_buckets(normalize_bucket_count(count), alloc);
+        std::vector<std::uint64_t> old_occupied(occupancy_words(old_buckets.size()));
+        buckets.swap(old_buckets);
+        occupied.swap(old_occupied);
+        hash_map_impl::for_each_set_bit(old_occupied.data(), old_occupied.size(), [&](size_type i) {
+            auto& bucket = old_buckets[i];
             while (!bucket.empty()) {
                 auto it = bucket.begin();
-                auto new_bucket_idx = hash_fn(it->first) % count;
-                new_buckets[new_bucket_idx].splice(
-                    new_buckets[new_bucket_idx].end(),
-                    bucket,
-                    it
-                );
+                auto& target = buckets[bucket_index(entry_hash(*it))];
+                target.splice(target.end(), bucket, it);
+                mark_occupied(target);
             }
+        });
+    }
+
+    // Same result as rehash(count), down to the order within each chain, with
+    // the node moves spread over worker threads. Worker w first splices the
+    // nodes of its slice of old buckets into one staging list per
+    // destination partition; after a join, worker p drains the staging lists
+    // of partition p in worker order into the new buckets. A last pass
+    // rebuilds the occupancy bitmap, one range of words per worker. Every
+    // list and word is only ever touched by one thread per phase, and no node
+    // is allocated or copied. Small tables, or threads < 2, take the serial
+    // path.
+    void rehash_parallel(size_type count, unsigned threads = std::thread::hardware_concurrency()) {
+        const size_type workers = threads;
+        if (workers < 2 || element_count < parallel_rehash_threshold) {
+            rehash(count);
+            return;
         }
-        buckets = std::move(new_buckets);
+
+        [[maybe_unused]] auto timer = counters.time_rehash();
+        auto old_buckets = make_buckets(normalize_bucket_count(count), alloc);
+        auto staging = make_buckets(workers * workers, alloc);
+        std::vector<std::uint64_t> old_occupied(occupancy_words(old_buckets.size()));
+        buckets.swap(old_buckets);
+        occupied.swap(old_occupied);
+        const auto new_count = buckets.size();
+
+        parallel_for(workers, [&](size_type w) {
+            const auto first = old_buckets.size() * w / workers;
+            const auto last = old_buckets.size() * (w + 1) / workers;
+            for (auto i = first; i < last; ++i) {
+                auto& bucket = old_buckets[i];
+                while (!bucket.empty()) {
+                    auto it = bucket.begin();
+                    auto partition = bucket_index(entry_hash(*it)) * workers / new_count;
+                    auto& target = staging[w * workers + partition];
+                    target.splice(target.end(), bucket, it);
+                }
+            }
+        });
+
+        parallel_for(workers, [&](size_type partition) {
+            for (size_type w = 0; w < workers; ++w) {
+                auto& source = staging[w * workers + partition];
+                while (!source.empty()) {
+                    auto it = source.begin();
+                    auto& target = buckets[bucket_index(entry_hash(*it))];
+                    target.splice(target.end(), source, it);
+                }
+            }
+        });
+
+        parallel_for(workers, [&](size_type w) {
+            const auto first = occupied.size() * w / workers;
+            const auto last = occupied.size() * (w + 1) / workers;
+            for (auto i = first; i < last; ++i) {
+                std::uint64_t bits = 0;
+                const auto base = i * 64;
+                for (auto b = base; b < std::min(base + 64, new_count); ++b) {
+                    bits |= std::uint64_t(!buckets[b].empty()) << (b - base);
+                }
+                occupied[i] = bits;
+            }
+        });
     }
 
     void print(std::ostream& os = std::cout) const {
@@ -339,7 +1293,8 @@ public:
             }
             else {
                 bool first = true;
-                for (const auto& item : buckets[i]) {
+                for (const auto& entry : buckets[i]) {
+                    const auto& item = entry_value(entry);
                     if (!first) os << " -> ";
                     os << "{" << item.first << ": " << item.second << "}";
                     first = false;
@@ -349,35 +1304,67 @@ public:
         }
     }
 
-    void print_collisions(std::ostream& os = std::cout) const {
-        std::unordered_map<size_t, std::vector<value_type>> hash_groups;
-
+    [[nodiscard]] hash_map_stats stats() const {
+        hash_map_stats result;
+        result.size = element_count;
+        result.bucket_count = buckets.size();
+        result.load_factor = load_factor();
         for (const auto& bucket : buckets) {
-            for (const auto& item : bucket) {
-                size_t h = hash_fn(item.first);
-                hash_groups[h].push_back(item);
+            const auto length = bucket.size();
+            if (length >= result.chain_length_histogram.size()) {
+                result.chain_length_histogram.resize(length + 1);
             }
+            ++result.chain_length_histogram[length];
+            result.max_chain_length = std::max(result.max_chain_length, length);
         }
+        if (!result.chain_length_histogram.empty()) {
+            result.empty_buckets = result.chain_length_histogram[0];
+        }
+        result.bytes_allocated = buckets.capacity() * sizeof(Bucket) +
+            occupied.capacity() * sizeof(std::uint64_t) +
+            element_count * (sizeof(Entry) + 2 * sizeof(void*));
+        counters.fill(result);
+        result.reseed_count = reseed_count_;
+        return result;
+    }
 
-        for (const auto& [hash_val, items] : hash_groups) {
-            if (items.size() > 1) {
-                os << "Hash " << hash_val << " (" << items.size() << " items):\n";
-                for (const auto& item : items) {
-                    os << "  {" << item.first << ": " << item.second << "}\n";
+    // Equal full hashes always share a bucket, so groups are found one chain
+    // at a time without copying any entry.
+    void print_collisions(std::ostream& os = std::cout) const {
+        for (const auto& bucket : buckets) {
+            if (bucket.size() < 2) {
+                continue;
+            }
+            for (auto it = bucket.begin(); it != bucket.end(); ++it) {
+                const auto hash_val = entry_hash(*it);
+                auto same_hash = [&](const Entry& entry) { return entry_hash(entry) == hash_val; };
+                if (std::any_of(bucket.begin(), it, same_hash)) {
+                    continue;
+                }
+                const auto count = std::count_if(it, bucket.end(), same_hash);
+                if (count > 1) {
+                    os << "Hash " << hash_val << " (" << count << " items):\n";
+                    for (auto jt = it; jt != bucket.end(); ++jt) {
+                        if (same_hash(*jt)) {
+                            const auto& item = entry_value(*jt);
+                            os << "  {" << item.first << ": " << item.second << "}\n";
+                        }
+                    }
                 }
             }
         }
     }
 
     void print_by_hash(size_t hash_value, std::ostream& os = std::cout) const {
-        size_t bucket_idx = hash_value % buckets.size();
+        size_t bucket_idx = bucket_index(hash_value);
         const auto& bucket = buckets[bucket_idx];
 
         os << "Elements with hash " << hash_value << " (bucket " << bucket_idx << "):\n";
         bool found = false;
 
-        for (const auto& item : bucket) {
-            if (hash_fn(item.first) == hash_value) {
+        for (const auto& entry : bucket) {
+            const auto& item = entry_value(entry);
+            if (entry_hash(entry) == hash_value) {
                 os << "  {" << item.first << ": " << item.second << "}\n";
                 found = true;
             }
@@ -1,6 +1,8 @@
 #ifndef HASH_MAP_H
 #define HASH_MAP_H
 
+#include <bit>
+#include <cstdint>
 #include <vector>
 #include <list>
 #include <functional>
@@ -9,9 +11,15 @@
 #include <utility>
 #include <initializer_list>
 #include <iostream>
-#include <unordered_map>
 #include <memory>
 #include <string_view>
+#include <span>
+#include <algorithm>
+#include <tuple>
+#include <cmath>
+
+#include "hashers.hpp"
+#include "hash_map_policies.hpp"
 
 namespace hash_map_impl {
 
@@ -25,28 +33,121 @@ namespace hash_map_impl {
         { eq(k1, k2) } -> std::convertible_to<bool>;
     };
 
+    // Hashers that already spread entropy over all bits declare is_avalanching;
+    // their results are used directly instead of going through the multiply.
+    template <typename Hash>
+    concept AvalanchingHasher = requires { typename Hash::is_avalanching; };
+
+    // Storage (chained_list, chained_small_vector<N>, open_addressing<Probe>)
+    // and Growth (power_of_two_growth, prime_growth) are the policies of
+    // hash_map_policies.hpp; the defaults give the classic chained table.
     template <typename Key, typename Value,
-        typename Hash = std::hash<Key>,
+        typename Hash = default_hash_t<Key>,
         typename KeyEqual = std::equal_to<>,
-        typename Allocator = std::allocator<std::pair<const Key, Value>>>
+        typename Allocator = std::allocator<std::pair<const Key, Value>>,
+        typename Storage = chained_list,
+        typename Growth = power_of_two_growth>
     class hash_map_core {
     protected:
-        using Bucket = std::list<std::pair<const Key, Value>, Allocator>;
-        std::vector<Bucket> buckets;
+        using Table = typename Storage::template table<Key, Value, Allocator, Growth>;
+        Table table;
         Hash hash_fn;
         KeyEqual key_eq;
-        [[no_unique_address]] Allocator alloc;
         float max_load_factor_ = 0.75f;
-        size_t element_count = 0;
 
-        size_t get_bucket(const Key& key) const noexcept {
-            return hash_fn(key) % buckets.size();
+        // Tables take their bucket from the top bits of what they are given,
+        // so hashes are passed through a Fibonacci multiply first, which also
+        // mixes identity hashes. Hashers that declare is_avalanching already
+        // spread entropy over all bits and are used as-is.
+        static std::uint64_t position(size_t hash) noexcept {
+            if constexpr (AvalanchingHasher<Hash>) {
+                return hash;
+            }
+            else {
+                return static_cast<std::uint64_t>(hash) * 0x9E3779B97F4A7C15ULL;
+            }
         }
 
-        void rehash_if_needed() {
-            if (load_factor() > max_load_factor_) {
-                rehash(buckets.size() * 2);
+        size_t bucket_index(size_t hash) const noexcept {
+            return Growth::index(position(hash), table.bucket_count());
+        }
+
+        // Keys of another type are hashed and compared as-is only when both
+        // Hash and KeyEqual are transparent; otherwise they are converted once.
+        template <typename K>
+        static constexpr bool is_heterogeneous_v = std::is_same_v<K, Key> ||
+            (Transparent<Hash> && Transparent<KeyEqual>);
+
+        void rehash_table(size_t count) {
+            table.rehash(count, [this](const Key& key) { return position(hash_fn(key)); });
+        }
+
+        // Prehashed operations: hash is hash_fn(key), computed by the caller.
+        // The public members reduce to these, and so can wrappers that hash
+        // a key once for several purposes.
+        template <typename K>
+        auto find_hashed(const K& key, size_t hash) noexcept {
+            return table.find(key, position(hash), key_eq);
+        }
+
+        template <typename K, typename... Args>
+        auto try_emplace_hashed(K&& key, size_t hash, Args&&... args) {
+            const auto pos = position(hash);
+            auto it = table.find(key, pos, key_eq);
+            if (it != table.end()) {
+                return std::pair{ it, false };
+            }
+            if (const auto count = table.rehash_target(max_load_factor_)) {
+                rehash_table(count);
             }
+            it = table.emplace_new(pos, std::piecewise_construct,
+                std::forward_as_tuple(std::forward<K>(key)),
+                std::forward_as_tuple(std::forward<Args>(args)...));
+            return std::pair{ it, true };
+        }
+
+        template <typename K>
+        bool erase_hashed(const K& key, size_t hash) noexcept {
+            return table.erase(key, position(hash), key_eq);
+        }
+
+        // Resolves keys a block at a time: all keys of a block are hashed and
+        // their buckets prefetched, then their chains, and only then are the
+        // keys looked up, so the misses of one block overlap.
+        template <typename K, typename Out>
+        size_t resolve_batch(std::span<K> keys, Out&& out) noexcept {
+            using key_arg = std::remove_const_t<K>;
+            size_t found = 0;
+
+            if constexpr (!is_heterogeneous_v<key_arg>) {
+                for (size_t i = 0; i < keys.size(); ++i) {
+                    auto* value = find(keys[i]);
+                    found += value != nullptr;
+                    out(i, value);
+                }
+            }
+            else {
+                constexpr size_t block = 16;
+                std::uint64_t hashes[block];
+
+                for (size_t base = 0; base < keys.size(); base += block) {
+                    const auto n = std::min(block, keys.size() - base);
+                    for (size_t i = 0; i < n; ++i) {
+                        hashes[i] = position(hash_fn(keys[base + i]));
+                        table.prefetch_bucket(hashes[i]);
+                    }
+                    for (size_t i = 0; i < n; ++i) {
+                        table.prefetch_chain(hashes[i]);
+                    }
+                    for (size_t i = 0; i < n; ++i) {
+                        auto it = table.find(keys[base + i], hashes[i], key_eq);
+                        Value* value = it != table.end() ? &it->second : nullptr;
+                        found += value != nullptr;
+                        out(base + i, value);
+                    }
+                }
+            }
+            return found;
         }
 
     public:
@@ -64,77 +165,17 @@ namespace hash_map_impl {
         using const_pointer = typename std::allocator_traits<Allocator>::const_pointer;
 
         template <bool IsConst>
-        class Iterator {
-            using BucketIterator = std::conditional_t<IsConst,
-                typename Bucket::const_iterator,
-                typename Bucket::iterator>;
-
-            using VectorIterator = std::conditional_t<IsConst,
-                typename std::vector<Bucket>::const_iterator,
-                typename std::vector<Bucket>::iterator>;
-
-            VectorIterator vec_it;
-            VectorIterator vec_end;
-            BucketIterator bucket_it;
-
-            void skip_empty_buckets() {
-                while (vec_it != vec_end && bucket_it == vec_it->end()) {
-                    ++vec_it;
-                    if (vec_it != vec_end) {
-                        bucket_it = vec_it->begin();
-                    }
-                }
-            }
-
-        public:
-            using iterator_category = std::forward_iterator_tag;
-            using value_type = std::pair<const Key, Value>;
-            using difference_type = std::ptrdiff_t;
-            using pointer = std::conditional_t<IsConst, const value_type*, value_type*>;
-            using reference = std::conditional_t<IsConst, const value_type&, value_type&>;
-
-            Iterator(VectorIterator begin, VectorIterator end)
-                : vec_it(begin), vec_end(end) {
-                if (vec_it != vec_end) {
-                    bucket_it = vec_it->begin();
-                    skip_empty_buckets();
-                }
-            }
-
-            Iterator(VectorIterator vec, Bucket& b, BucketIterator bit)
-                : vec_it(vec), vec_end(vec + 1), bucket_it(bit) {
-            }
+        using Iterator = typename Table::template Iterator<IsConst>;
 
-            Iterator& operator++() {
-                ++bucket_it;
-                skip_empty_buckets();
-                return *this;
-            }
-
-            Iterator operator++(int) {
-                Iterator tmp = *this;
-                ++(*this);
-                return tmp;
-            }
-
-            reference operator*() const { return *bucket_it; }
-            pointer operator->() const { return &(*bucket_it); }
-
-            bool operator==(const Iterator& other) const {
-                return vec_it == other.vec_it &&
-                    (vec_it == vec_end || bucket_it == other.bucket_it);
-            }
-
-            bool operator!=(const Iterator& other) const {
-                return !(*this == other);
-            }
-        };
+        using iterator = Iterator<false>;
+        using const_iterator = Iterator<true>;
 
         explicit hash_map_core(size_type bucket_count = 16,
             const Hash& hash = Hash(),
             const KeyEqual& equal = KeyEqual(),
             const Allocator& alloc = Allocator())
-            : buckets(bucket_count), hash_fn(hash), key_eq(equal), alloc(alloc) {
+            : table(Growth::normalize(bucket_count), alloc),
+            hash_fn(hash), key_eq(equal) {
         }
 
         hash_map_core(std::initializer_list<value_type> init,
@@ -148,28 +189,20 @@ namespace hash_map_impl {
             }
         }
 
+        // Clones the table layout entry by entry: nothing is rehashed or
+        // compared, and the load factor is already within bounds.
         hash_map_core(const hash_map_core& other)
-            : buckets(other.buckets.size()),
+            : table(other.table, std::allocator_traits<Allocator>::select_on_container_copy_construction(other.table.get_allocator())),
             hash_fn(other.hash_fn),
             key_eq(other.key_eq),
-            alloc(std::allocator_traits<Allocator>::select_on_container_copy_construction(other.alloc)),
-            max_load_factor_(other.max_load_factor_),
-            element_count(0) {
-            for (const auto& bucket : other.buckets) {
-                for (const auto& pair : bucket) {
-                    insert(pair.first, pair.second);
-                }
-            }
+            max_load_factor_(other.max_load_factor_) {
         }
 
         hash_map_core(hash_map_core&& other) noexcept
-            : buckets(std::move(other.buckets)),
+            : table(std::move(other.table)),
             hash_fn(std::move(other.hash_fn)),
             key_eq(std::move(other.key_eq)),
-            alloc(std::move(other.alloc)),
-            max_load_factor_(other.max_load_factor_),
-            element_count(other.element_count) {
-            other.element_count = 0;
+            max_load_factor_(other.max_load_factor_) {
         }
 
         hash_map_core& operator=(hash_map_core other) noexcept {
@@ -179,42 +212,80 @@ namespace hash_map_impl {
 
         void swap(hash_map_core& other) noexcept {
             using std::swap;
-            swap(buckets, other.buckets);
+            table.swap(other.table);
             swap(hash_fn, other.hash_fn);
             swap(key_eq, other.key_eq);
-            swap(alloc, other.alloc);
             swap(max_load_factor_, other.max_load_factor_);
-            swap(element_count, other.element_count);
         }
 
         template <typename K, typename V>
+            requires std::constructible_from<Key, K>
         std::pair<Iterator<false>, bool> insert(K&& key, V&& value) {
-            auto bucket_idx = get_bucket(key);
-            auto& bucket = buckets[bucket_idx];
+            return try_emplace(std::forward<K>(key), std::forward<V>(value));
+        }
 
-            for (auto it = bucket.begin(); it != bucket.end(); ++it) {
-                if (key_eq(it->first, key)) {
-                    return { Iterator<false>(buckets.begin() + bucket_idx, bucket, it), false };
-                }
+        // Constructs the value from args only if the key is absent; otherwise
+        // neither the key nor args are touched. One hash, one lookup.
+        template <typename K, typename... Args>
+            requires std::constructible_from<Key, K>
+        std::pair<Iterator<false>, bool> try_emplace(K&& key, Args&&... args) {
+            if constexpr (!is_heterogeneous_v<std::remove_cvref_t<K>>) {
+                return try_emplace(Key(std::forward<K>(key)), std::forward<Args>(args)...);
             }
+            else {
+                const auto hash = hash_fn(key);
+                return try_emplace_hashed(std::forward<K>(key), hash, std::forward<Args>(args)...);
+            }
+        }
 
-            bucket.emplace_back(std::forward<K>(key), std::forward<V>(value));
-            ++element_count;
-            rehash_if_needed();
-            return { Iterator<false>(buckets.begin() + bucket_idx, bucket, std::prev(bucket.end())), true };
+        template <typename K, typename V>
+            requires std::constructible_from<Key, K>
+        std::pair<Iterator<false>, bool> emplace(K&& key, V&& value) {
+            return try_emplace(std::forward<K>(key), std::forward<V>(value));
+        }
+
+        // The key is built from key_args up front, since it has to be hashed;
+        // the value is only constructed if that key is absent.
+        template <typename... KeyArgs, typename... ValueArgs>
+        std::pair<Iterator<false>, bool> emplace(std::piecewise_construct_t,
+            std::tuple<KeyArgs...> key_args, std::tuple<ValueArgs...> value_args) {
+            return std::apply([&](auto&&... args) {
+                return try_emplace(std::make_from_tuple<Key>(std::move(key_args)),
+                    std::forward<decltype(args)>(args)...);
+            }, std::move(value_args));
+        }
+
+        // Inserts the pair, or assigns value to the existing entry. The bool is
+        // true if a new entry was created.
+        template <typename K, typename V>
+            requires std::constructible_from<Key, K>
+        std::pair<Iterator<false>, bool> insert_or_assign(K&& key, V&& value) {
+            // try_emplace leaves value untouched when the key exists, so it is
+            // still there to assign from.
+            auto result = try_emplace(std::forward<K>(key), std::forward<V>(value));
+            if (!result.second) {
+                result.first->second = std::forward<V>(value);
+            }
+            return result;
+        }
+
+        // Update in place: calls fn(Value&) on the existing value, or on a
+        // value-initialized one inserted for the key, and returns what fn returns.
+        template <typename K, typename F>
+            requires std::constructible_from<Key, K>
+        decltype(auto) compute(K&& key, F&& fn) {
+            return std::invoke(std::forward<F>(fn), try_emplace(std::forward<K>(key)).first->second);
         }
 
         template <typename K>
         Value* find(const K& key) noexcept {
-            auto bucket_idx = get_bucket(key);
-            auto& bucket = buckets[bucket_idx];
-
-            for (auto& item : bucket) {
-                if (key_eq(item.first, key)) {
-                    return &item.second;
-                }
+            if constexpr (!is_heterogeneous_v<K>) {
+                return find(Key(key));
+            }
+            else {
+                auto it = find_hashed(key, hash_fn(key));
+                return it != table.end() ? &it->second : nullptr;
             }
-            return nullptr;
         }
 
         template <typename K>
@@ -222,87 +293,89 @@ namespace hash_map_impl {
             return const_cast<hash_map_core*>(this)->find(key);
         }
 
+        // Batched find: results[i] receives find(keys[i]). results must be at
+        // least as long as keys. Returns the number of keys found.
+        template <typename K, std::size_t Extent>
+        size_type find_batch(std::span<K, Extent> keys, std::span<Value*> results) noexcept {
+            return resolve_batch(std::span<K>(keys), [&](size_type i, Value* value) { results[i] = value; });
+        }
+
+        template <typename K, std::size_t Extent>
+        size_type find_batch(std::span<K, Extent> keys, std::span<const Value*> results) const noexcept {
+            return const_cast<hash_map_core*>(this)->resolve_batch(std::span<K>(keys),
+                [&](size_type i, const Value* value) { results[i] = value; });
+        }
+
+        template <typename K, std::size_t Extent>
+        size_type contains_batch(std::span<K, Extent> keys, std::span<bool> results) const noexcept {
+            return const_cast<hash_map_core*>(this)->resolve_batch(std::span<K>(keys),
+                [&](size_type i, const Value* value) { results[i] = value != nullptr; });
+        }
+
         template <typename K>
         Value& operator[](K&& key) {
-            if (auto* val = find(key)) {
-                return *val;
-            }
-
-            auto bucket_idx = get_bucket(key);
-            auto& bucket = buckets[bucket_idx];
-            bucket.emplace_back(std::forward<K>(key), Value());
-            ++element_count;
-            rehash_if_needed();
-            return bucket.back().second;
+            return try_emplace(std::forward<K>(key)).first->second;
         }
 
         template <typename K>
         size_type erase(const K& key) noexcept {
-            auto bucket_idx = get_bucket(key);
-            auto& bucket = buckets[bucket_idx];
-
-            for (auto it = bucket.begin(); it != bucket.end(); ++it) {
-                if (key_eq(it->first, key)) {
-                    bucket.erase(it);
-                    --element_count;
-                    return 1;
-                }
+            if constexpr (!is_heterogeneous_v<K>) {
+                return erase(Key(key));
+            }
+            else {
+                return erase_hashed(key, hash_fn(key)) ? 1 : 0;
             }
-            return 0;
         }
 
         void clear() noexcept {
-            for (auto& bucket : buckets) {
-                bucket.clear();
-            }
-            element_count = 0;
+            table.clear();
         }
 
+        // Never picks fewer buckets than size() needs at max_load_factor().
         void rehash(size_type count) {
-            std::vector<Bucket> new_buckets(count);
-            for (auto& bucket : buckets) {
-                while (!bucket.empty()) {
-                    auto it = bucket.begin();
-                    auto new_bucket_idx = hash_fn(it->first) % count;
-                    new_buckets[new_bucket_idx].splice(
-                        new_buckets[new_bucket_idx].end(),
-                        bucket,
-                        it
-                    );
-                }
-            }
-            buckets = std::move(new_buckets);
+            const auto needed = static_cast<size_type>(std::ceil(static_cast<float>(size()) / max_load_factor_));
+            rehash_table(Growth::normalize(std::max(count, needed)));
         }
 
-        size_type size() const noexcept { return element_count; }
-        bool empty() const noexcept { return element_count == 0; }
-        size_type bucket_count() const noexcept { return buckets.size(); }
-        size_type bucket_size(size_type n) const { return buckets[n].size(); }
-        float load_factor() const noexcept { return static_cast<float>(element_count) / buckets.size(); }
+        size_type size() const noexcept { return table.size(); }
+        bool empty() const noexcept { return table.size() == 0; }
+        size_type bucket_count() const noexcept { return table.bucket_count(); }
+        allocator_type get_allocator() const noexcept { return table.get_allocator(); }
+        size_type bucket_size(size_type n) const { return table.bucket_size(n); }
+        float load_factor() const noexcept { return static_cast<float>(size()) / bucket_count(); }
         float max_load_factor() const noexcept { return max_load_factor_; }
-        void max_load_factor(float ml) { max_load_factor_ = ml; rehash_if_needed(); }
 
-        using iterator = Iterator<false>;
-        using const_iterator = Iterator<true>;
+        void max_load_factor(float ml) {
+            max_load_factor_ = ml;
+            if (load_factor() > max_load_factor_) {
+                rehash(0);
+            }
+        }
 
-        iterator begin() noexcept { return iterator(buckets.begin(), buckets.end()); }
-        const_iterator begin() const noexcept { return const_iterator(buckets.begin(), buckets.end()); }
-        const_iterator cbegin() const noexcept { return const_iterator(buckets.begin(), buckets.end()); }
-        iterator end() noexcept { return iterator(buckets.end(), buckets.end()); }
-        const_iterator end() const noexcept { return const_iterator(buckets.end(), buckets.end()); }
-        const_iterator cend() const noexcept { return const_iterator(buckets.end(), buckets.end()); }
+        iterator begin() noexcept { return table.begin(); }
+        const_iterator begin() const noexcept { return table.begin(); }
+        const_iterator cbegin() const noexcept { return table.begin(); }
+        iterator end() noexcept { return table.end(); }
+        const_iterator end() const noexcept { return table.end(); }
+        const_iterator cend() const noexcept { return table.end(); }
     };
 
 } // namespace hash_map_impl
 
+// Pick a layout per instantiation, e.g.
+//     hash_map<std::string, int, string_hash, std::equal_to<>,
+//         std::allocator<std::pair<const std::string, int>>,
+//         open_addressing<hash_map_impl::robin_hood_probing>>
 template <typename Key, typename Value,
-    typename Hash = std::hash<Key>,
+    typename Hash = default_hash_t<Key>,
     typename KeyEqual = std::equal_to<>,
-    typename Allocator = std::allocator<std::pair<const Key, Value>>>
+    typename Allocator = std::allocator<std::pair<const Key, Value>>,
+    typename Storage = chained_list,
+    typename Growth = hash_map_impl::power_of_two_growth>
     requires hash_map_impl::ValidHasher<Hash, Key>&&
 hash_map_impl::KeyComparator<KeyEqual, Key>
-class hash_map : public hash_map_impl::hash_map_core<Key, Value, Hash, KeyEqual, Allocator> {
-    using Base = hash_map_impl::hash_map_core<Key, Value, Hash, KeyEqual, Allocator>;
+class hash_map : public hash_map_impl::hash_map_core<Key, Value, Hash, KeyEqual, Allocator, Storage, Growth> {
+    using Base = hash_map_impl::hash_map_core<Key, Value, Hash, KeyEqual, Allocator, Storage, Growth>;
 
 public:
     using Base::Base;
@@ -321,49 +394,57 @@ public:
             }
             else {
                 bool first = true;
-                for (const auto& item : this->buckets[i]) {
+                this->table.for_each_in_bucket(i, [&](const auto& item) {
                     if (!first) os << " -> ";
                     os << "{" << item.first << ": " << item.second << "}";
                     first = false;
-                }
+                });
             }
             os << "\n";
         }
     }
 
+    // Equal full hashes always share a bucket, so groups are found one bucket
+    // at a time, through pointers rather than copies of the entries.
     void print_collisions(std::ostream& os = std::cout) const {
-        std::unordered_map<size_t, std::vector<typename Base::value_type>> hash_groups;
-
-        for (const auto& bucket : this->buckets) {
-            for (const auto& item : bucket) {
-                size_t h = this->hash_fn(item.first);
-                hash_groups[h].push_back(item);
+        std::vector<const typename Base::value_type*> bucket;
+        for (size_t i = 0; i < this->bucket_count(); ++i) {
+            bucket.clear();
+            this->table.for_each_in_bucket(i, [&](const auto& item) { bucket.push_back(&item); });
+            if (bucket.size() < 2) {
+                continue;
             }
-        }
-
-        for (const auto& [hash_val, items] : hash_groups) {
-            if (items.size() > 1) {
-                os << "Hash " << hash_val << " (" << items.size() << " items):\n";
-                for (const auto& item : items) {
-                    os << "  {" << item.first << ": " << item.second << "}\n";
+            for (auto it = bucket.begin(); it != bucket.end(); ++it) {
+                const size_t hash_val = this->hash_fn((*it)->first);
+                auto same_hash = [&](const auto* item) { return this->hash_fn(item->first) == hash_val; };
+                if (std::any_of(bucket.begin(), it, same_hash)) {
+                    continue;
+                }
+                const auto count = std::count_if(it, bucket.end(), same_hash);
+                if (count > 1) {
+                    os << "Hash " << hash_val << " (" << count << " items):\n";
+                    for (auto jt = it; jt != bucket.end(); ++jt) {
+                        if (same_hash(*jt)) {
+                            os << "  {" << (*jt)->first << ": " << (*jt)->second << "}\n";
+                        }
+                    }
                 }
             }
         }
     }
 
     void print_by_hash(size_t hash_value, std::ostream& os = std::cout) const {
-        size_t bucket_idx = hash_value % this->bucket_count();
-        const auto& bucket = this->buckets[bucket_idx];
+        size_t bucket_idx = this->bucket_index(hash_value);
 
         os << "Elements with hash " << hash_value << " (bucket " << bucket_idx << "):\n";
         bool found = false;
 
-        for (const auto& item : bucket) {
+        this->table.for_each_in_bucket(bucket_idx, [&](const auto& item) {
             if (this->hash_fn(item.first) == hash_value) {
                 os << "  {" << item.first << ": " << item.second << "}\n";
                 found = true;
             }
-        }
+        });
 
         if (!found) {
             os << "  No elements with this hash found\n";
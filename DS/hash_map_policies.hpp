@@ -0,0 +1,896 @@
+#ifndef HASH_MAP_POLICIES_H
+#define HASH_MAP_POLICIES_H
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "prefetch.hpp"
+
+// Layout policies for hash_map_core. A core is parameterized by a storage
+// policy, which decides how entries are laid out and probed, and a growth
+// policy, which decides the sequence of bucket counts and how a hash picks a
+// bucket. Every combination has the same public API.
+//
+// Storage policies expose `template <Key, Value, Allocator, Growth> table`.
+// A table receives hashes that the core has already mixed, so their top bits
+// are usable, and never sees the user's hasher except through the callable
+// handed to rehash. Its interface:
+//
+//     table(size_t bucket_count, const Allocator&);
+//     table(const table& other, const Allocator&);   copies the layout as-is
+//     Iterator<IsConst>, begin(), end()
+//     find(key, hash, key_eq) -> iterator, end() if absent
+//     emplace_new(hash, args...) -> iterator     key known to be absent
+//     erase(key, hash, key_eq) -> bool
+//     rehash(bucket_count, hash_of)
+//     rehash_target(max_load) -> size_t          bucket count to rehash to
+//                                                before one more insert, or 0
+//     prefetch_bucket(hash), prefetch_chain(hash)
+//     size(), bucket_count(), bucket_size(n), for_each_in_bucket(n, f), clear()
+//     get_allocator(), swap(other)
+//
+// References to entries are stable across rehash only for chained_list.
+namespace hash_map_impl {
+
+    // Growth policies: normalize(n) is the smallest valid bucket count not
+    // below n, grow(n) the next one after n, index(hash, n) the home bucket.
+
+    // Doubling power-of-two counts. The bucket is taken from the top bits of
+    // the hash with one shift, and quadratic probing covers every slot.
+    struct power_of_two_growth {
+        static constexpr bool power_of_two = true;
+
+        static std::size_t normalize(std::size_t count) noexcept {
+            return std::bit_ceil(count < 2 ? std::size_t(2) : count);
+        }
+
+        static std::size_t grow(std::size_t count) noexcept {
+            return count * 2;
+        }
+
+        static std::size_t index(std::uint64_t hash, std::size_t count) noexcept {
+            return static_cast<std::size_t>(hash >> (64 - std::countr_zero(count)));
+        }
+    };
+
+    // Prime counts, each the first prime above a power of two. The bucket is
+    // hash % count, which costs a division per lookup but uses every bit of
+    // the hash; useful when keys collide in the top bits anyway.
+    struct prime_growth {
+        static constexpr bool power_of_two = false;
+
+        static constexpr std::uint64_t primes[] = {
+            5, 11, 17, 37, 67, 131, 257, 521, 1031, 2053, 4099, 8209, 16411, 32771, 65537,
+            131101, 262147, 524309, 1048583, 2097169, 4194319, 8388617, 16777259,
+            33554467, 67108879, 134217757, 268435459, 536870923, 1073741827,
+            2147483659ULL, 4294967311ULL, 8589934609ULL, 17179869209ULL, 34359738421ULL,
+            68719476767ULL, 137438953481ULL, 274877906951ULL, 549755813911ULL,
+            1099511627791ULL, 2199023255579ULL, 4398046511119ULL, 8796093022237ULL,
+            17592186044423ULL, 35184372088891ULL, 70368744177679ULL, 140737488355333ULL,
+        };
+
+        static std::size_t normalize(std::size_t count) {
+            const auto it = std::lower_bound(std::begin(primes), std::end(primes), static_cast<std::uint64_t>(count));
+            if (it == std::end(primes) || *it > SIZE_MAX) {
+                throw std::length_error("prime_growth: bucket count too large");
+            }
+            return static_cast<std::size_t>(*it);
+        }
+
+        static std::size_t grow(std::size_t count) {
+            return normalize(count + 1);
+        }
+
+        static std::size_t index(std::uint64_t hash, std::size_t count) noexcept {
+            return static_cast<std::size_t>(hash % count);
+        }
+    };
+
+    // Probe sequences for open_addressing. next(index, step, count) is the
+    // slot probed after index, where step counts the probes made so far.
+
+    struct linear_probing {
+        static constexpr bool robin_hood = false;
+        static constexpr bool needs_power_of_two = false;
+
+        static std::size_t next(std::size_t index, std::size_t, std::size_t count) noexcept {
+            return ++index == count ? 0 : index;
+        }
+    };
+
+    // Triangular steps (1, 2, 3, ...) break up the clusters linear probing
+    // builds, and visit every slot exactly once when count is a power of two.
+    struct quadratic_probing {
+        static constexpr bool robin_hood = false;
+        static constexpr bool needs_power_of_two = true;
+
+        static std::size_t next(std::size_t index, std::size_t step, std::size_t count) noexcept {
+            return (index + step) & (count - 1);
+        }
+    };
+
+    // Linear probing that keeps every run ordered by home slot: an insert
+    // takes the slot of the first entry closer to its home than the new key
+    // is, and shifts the rest of the run along. A miss stops as soon as it
+    // passes where the key would have been, and erase shifts the run back
+    // instead of leaving a tombstone.
+    struct robin_hood_probing {
+        static constexpr bool robin_hood = true;
+        static constexpr bool needs_power_of_two = false;
+
+        static std::size_t next(std::size_t index, std::size_t, std::size_t count) noexcept {
+            return ++index == count ? 0 : index;
+        }
+    };
+
+    // Bucket of chained_small_vector: up to InlineCapacity entries live in the
+    // bucket itself, more spill to a heap array that doubles as it fills.
+    // Erase moves the last entry into the hole, so order is not kept.
+    template <typename T, typename Allocator, std::size_t InlineCapacity>
+    class chain_vector {
+        using MutableT = std::pair<std::remove_const_t<typename T::first_type>, typename T::second_type>;
+
+        // The mutable view lets entries be moved out of a slot on growth
+        // and erase instead of copied.
+        union slot_type {
+            T value;
+            MutableT mutable_value;
+
+            slot_type() noexcept {}
+            ~slot_type() {}
+        };
+
+        using SlotAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<slot_type>;
+        using SlotTraits = std::allocator_traits<SlotAllocator>;
+
+        slot_type* heap = nullptr;
+        std::uint32_t size_ = 0;
+        std::uint32_t capacity_ = InlineCapacity;
+        [[no_unique_address]] Allocator alloc;
+        slot_type inline_slots[InlineCapacity];
+
+        // Iterators are plain T pointers stepping over the slots.
+        static_assert(sizeof(slot_type) == sizeof(T));
+
+        slot_type* data() noexcept { return heap ? heap : inline_slots; }
+        const slot_type* data() const noexcept { return heap ? heap : inline_slots; }
+
+        // Entries are moved, or copied when their move may throw, and the
+        // old ones destroyed only once all have made it; a throwing copy
+        // leaves the bucket as it was.
+        void grow() {
+            SlotAllocator slot_alloc(alloc);
+            const auto new_capacity = capacity_ * 2;
+            auto* fresh = SlotTraits::allocate(slot_alloc, new_capacity);
+            auto* old = data();
+            std::uint32_t i = 0;
+            try {
+                for (; i < size_; ++i) {
+                    SlotTraits::construct(slot_alloc, &fresh[i].mutable_value, std::move_if_noexcept(old[i].mutable_value));
+                }
+            }
+            catch (...) {
+                while (i-- > 0) {
+                    SlotTraits::destroy(slot_alloc, &fresh[i].mutable_value);
+                }
+                SlotTraits::deallocate(slot_alloc, fresh, new_capacity);
+                throw;
+            }
+            for (i = 0; i < size_; ++i) {
+                SlotTraits::destroy(slot_alloc, &old[i].mutable_value);
+            }
+            free_heap();
+            heap = fresh;
+            capacity_ = new_capacity;
+        }
+
+        void free_heap() noexcept {
+            if (heap) {
+                SlotAllocator slot_alloc(alloc);
+                SlotTraits::deallocate(slot_alloc, heap, capacity_);
+                heap = nullptr;
+                capacity_ = InlineCapacity;
+            }
+        }
+
+    public:
+        using iterator = T*;
+        using const_iterator = const T*;
+
+        explicit chain_vector(const Allocator& a) noexcept : alloc(a) {
+        }
+
+        chain_vector(chain_vector&& other) noexcept(std::is_nothrow_move_constructible_v<MutableT>)
+            : alloc(other.alloc) {
+            if (other.heap) {
+                heap = std::exchange(other.heap, nullptr);
+                size_ = std::exchange(other.size_, 0);
+                capacity_ = std::exchange(other.capacity_, static_cast<std::uint32_t>(InlineCapacity));
+            }
+            else {
+                for (std::uint32_t i = 0; i < other.size_; ++i) {
+                    emplace_back(std::move(other.inline_slots[i].mutable_value));
+                }
+                other.clear();
+            }
+        }
+
+        chain_vector(const chain_vector&) = delete;
+        chain_vector& operator=(const chain_vector&) = delete;
+        chain_vector& operator=(chain_vector&&) = delete;
+
+        ~chain_vector() {
+            clear();
+            free_heap();
+        }
+
+        template <typename... Args>
+        T& emplace_back(Args&&... args) {
+            if (size_ == capacity_) {
+                grow();
+            }
+            SlotAllocator slot_alloc(alloc);
+            auto* slot = &data()[size_];
+            SlotTraits::construct(slot_alloc, &slot->value, std::forward<Args>(args)...);
+            ++size_;
+            return slot->value;
+        }
+
+        void erase(iterator it) noexcept {
+            // The last entry is moved into the hole, and a move that threw
+            // there would leave it unfilled.
+            static_assert(std::is_nothrow_move_constructible_v<MutableT>,
+                "chained_small_vector erase needs entries that move without throwing");
+            SlotAllocator slot_alloc(alloc);
+            auto* slots = data();
+            auto* slot = reinterpret_cast<slot_type*>(it);
+            SlotTraits::destroy(slot_alloc, &slot->value);
+            if (--size_ != static_cast<std::uint32_t>(slot - slots)) {
+                SlotTraits::construct(slot_alloc, &slot->mutable_value, std::move(slots[size_].mutable_value));
+                SlotTraits::destroy(slot_alloc, &slots[size_].mutable_value);
+            }
+        }
+
+        void clear() noexcept {
+            SlotAllocator slot_alloc(alloc);
+            auto* slots = data();
+            for (std::uint32_t i = 0; i < size_; ++i) {
+                SlotTraits::destroy(slot_alloc, &slots[i].value);
+            }
+            size_ = 0;
+        }
+
+        // Moves every entry out through fn(MutableT&&), leaving the bucket empty.
+        template <typename F>
+        void drain(F&& fn) {
+            SlotAllocator slot_alloc(alloc);
+            auto* slots = data();
+            for (std::uint32_t i = 0; i < size_; ++i) {
+                fn(std::move(slots[i].mutable_value));
+                SlotTraits::destroy(slot_alloc, &slots[i].mutable_value);
+            }
+            size_ = 0;
+            free_heap();
+        }
+
+        iterator begin() noexcept { return &data()->value; }
+        iterator end() noexcept { return &data()->value + size_; }
+        const_iterator begin() const noexcept { return &data()->value; }
+        const_iterator end() const noexcept { return &data()->value + size_; }
+
+        std::size_t size() const noexcept { return size_; }
+        bool empty() const noexcept { return size_ == 0; }
+    };
+
+    // Separate chaining: a vector of buckets, each a list-like Bucket.
+    template <typename Key, typename Value, typename Allocator, typename Growth, typename Bucket>
+    class chained_table {
+        using value_type = std::pair<const Key, Value>;
+
+        std::vector<Bucket> buckets;
+        std::size_t size_ = 0;
+        [[no_unique_address]] Allocator alloc;
+
+        static constexpr bool node_based = requires(Bucket b) { b.splice(b.end(), b, b.begin()); };
+
+        // Every bucket is built from the map's allocator, so all of them
+        // compare equal and list nodes can be spliced between them on rehash.
+        static std::vector<Bucket> make_buckets(std::size_t count, const Allocator& a) {
+            std::vector<Bucket> result;
+            result.reserve(count);
+            for (std::size_t i = 0; i < count; ++i) {
+                result.emplace_back(a);
+            }
+            return result;
+        }
+
+        Bucket& bucket_of(std::uint64_t hash) noexcept {
+            return buckets[Growth::index(hash, buckets.size())];
+        }
+
+    public:
+        template <bool IsConst>
+        class Iterator {
+            using BucketIterator = std::conditional_t<IsConst,
+                typename Bucket::const_iterator,
+                typename Bucket::iterator>;
+
+            using VectorIterator = std::conditional_t<IsConst,
+                typename std::vector<Bucket>::const_iterator,
+                typename std::vector<Bucket>::iterator>;
+
+            VectorIterator vec_it;
+            VectorIterator vec_end;
+            BucketIterator bucket_it;
+
+            template <bool> friend class Iterator;
+
+            void skip_empty_buckets() {
+                while (vec_it != vec_end && bucket_it == vec_it->end()) {
+                    ++vec_it;
+                    if (vec_it != vec_end) {
+                        bucket_it = vec_it->begin();
+                    }
+                }
+            }
+
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = std::pair<const Key, Value>;
+            using difference_type = std::ptrdiff_t;
+            using pointer = std::conditional_t<IsConst, const value_type*, value_type*>;
+            using reference = std::conditional_t<IsConst, const value_type&, value_type&>;
+
+            Iterator() = default;
+
+            Iterator(VectorIterator begin, VectorIterator end)
+                : vec_it(begin), vec_end(end) {
+                if (vec_it != vec_end) {
+                    bucket_it = vec_it->begin();
+                    skip_empty_buckets();
+                }
+            }
+
+            Iterator(VectorIterator vec, VectorIterator end, BucketIterator bit)
+                : vec_it(vec), vec_end(end), bucket_it(bit) {
+            }
+
+            template <bool WasConst>
+                requires (IsConst && !WasConst)
+            Iterator(const Iterator<WasConst>& other)
+                : vec_it(other.vec_it), vec_end(other.vec_end), bucket_it(other.bucket_it) {
+            }
+
+            Iterator& operator++() {
+                ++bucket_it;
+                skip_empty_buckets();
+                return *this;
+            }
+
+            Iterator operator++(int) {
+                Iterator tmp = *this;
+                ++(*this);
+                return tmp;
+            }
+
+            reference operator*() const { return *bucket_it; }
+            pointer operator->() const { return &(*bucket_it); }
+
+            bool operator==(const Iterator& other) const {
+                return vec_it == other.vec_it &&
+                    (vec_it == vec_end || bucket_it == other.bucket_it);
+            }
+
+            bool operator!=(const Iterator& other) const {
+                return !(*this == other);
+            }
+        };
+
+        using iterator = Iterator<false>;
+        using const_iterator = Iterator<true>;
+
+        chained_table(std::size_t bucket_count, const Allocator& a)
+            : buckets(make_buckets(bucket_count, a)), alloc(a) {
+        }
+
+        // Clones the bucket layout entry by entry: nothing is rehashed or compared.
+        chained_table(const chained_table& other, const Allocator& a)
+            : buckets(make_buckets(other.buckets.size(), a)), size_(other.size_), alloc(a) {
+            for (std::size_t i = 0; i < buckets.size(); ++i) {
+                for (const auto& item : other.buckets[i]) {
+                    buckets[i].emplace_back(item);
+                }
+            }
+        }
+
+        chained_table(chained_table&& other) noexcept
+            : buckets(std::move(other.buckets)), size_(std::exchange(other.size_, 0)), alloc(std::move(other.alloc)) {
+        }
+
+        void swap(chained_table& other) noexcept {
+            using std::swap;
+            buckets.swap(other.buckets);
+            swap(size_, other.size_);
+            swap(alloc, other.alloc);
+        }
+
+        template <typename K, typename KeyEqual>
+        iterator find(const K& key, std::uint64_t hash, const KeyEqual& key_eq) noexcept {
+            const auto index = Growth::index(hash, buckets.size());
+            auto& bucket = buckets[index];
+            for (auto it = bucket.begin(); it != bucket.end(); ++it) {
+                if (key_eq(it->first, key)) {
+                    return iterator(buckets.begin() + index, buckets.end(), it);
+                }
+            }
+            return end();
+        }
+
+        template <typename... Args>
+        iterator emplace_new(std::uint64_t hash, Args&&... args) {
+            const auto index = Growth::index(hash, buckets.size());
+            auto& bucket = buckets[index];
+            bucket.emplace_back(std::forward<Args>(args)...);
+            ++size_;
+            return iterator(buckets.begin() + index, buckets.end(), std::prev(bucket.end()));
+        }
+
+        template <typename K, typename KeyEqual>
+        bool erase(const K& key, std::uint64_t hash, const KeyEqual& key_eq) noexcept {
+            auto& bucket = bucket_of(hash);
+            for (auto it = bucket.begin(); it != bucket.end(); ++it) {
+                if (key_eq(it->first, key)) {
+                    bucket.erase(it);
+                    --size_;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void clear() noexcept {
+            for (auto& bucket : buckets) {
+                bucket.clear();
+            }
+            size_ = 0;
+        }
+
+        // List nodes are spliced into their new buckets, so entries keep their
+        // addresses; other buckets move their entries.
+        template <typename HashOf>
+        void rehash(std::size_t count, HashOf&& hash_of) {
+            auto old_buckets = make_buckets(count, alloc);
+            buckets.swap(old_buckets);
+            for (auto& bucket : old_buckets) {
+                if constexpr (node_based) {
+                    while (!bucket.empty()) {
+                        auto it = bucket.begin();
+                        auto& target = bucket_of(hash_of(it->first));
+                        target.splice(target.end(), bucket, it);
+                    }
+                }
+                else {
+                    bucket.drain([&](auto&& item) {
+                        bucket_of(hash_of(item.first)).emplace_back(std::move(item));
+                    });
+                }
+            }
+        }
+
+        std::size_t rehash_target(float max_load) const noexcept {
+            const auto count = buckets.size();
+            return static_cast<float>(size_ + 1) > max_load * static_cast<float>(count) ? Growth::grow(count) : 0;
+        }
+
+        void prefetch_bucket(std::uint64_t hash) const noexcept {
+            prefetch(&buckets[Growth::index(hash, buckets.size())]);
+        }
+
+        // Only meaningful once prefetch_bucket has had time to land.
+        void prefetch_chain(std::uint64_t hash) const noexcept {
+            const auto& bucket = buckets[Growth::index(hash, buckets.size())];
+            if (!bucket.empty()) {
+                prefetch(&*bucket.begin());
+            }
+        }
+
+        Allocator get_allocator() const noexcept { return alloc; }
+        std::size_t size() const noexcept { return size_; }
+        std::size_t bucket_count() const noexcept { return buckets.size(); }
+        std::size_t bucket_size(std::size_t n) const { return buckets[n].size(); }
+
+        template <typename F>
+        void for_each_in_bucket(std::size_t n, F&& fn) const {
+            for (const auto& item : buckets[n]) {
+                fn(item);
+            }
+        }
+
+        iterator begin() noexcept { return iterator(buckets.begin(), buckets.end()); }
+        const_iterator begin() const noexcept { return const_iterator(buckets.begin(), buckets.end()); }
+        iterator end() noexcept { return iterator(buckets.end(), buckets.end()); }
+        const_iterator end() const noexcept { return const_iterator(buckets.end(), buckets.end()); }
+    };
+
+    // Open addressing: one slot per bucket, holding the entry and its hash.
+    // The stored hash makes rehash free of hasher calls and screens out most
+    // unequal keys before key_eq runs.
+    template <typename Key, typename Value, typename Allocator, typename Growth, typename Probe>
+    class open_table {
+        static_assert(!Probe::needs_power_of_two || Growth::power_of_two,
+            "this probe sequence needs power-of-two bucket counts");
+
+        using value_type = std::pair<const Key, Value>;
+
+        // meta is empty_slot, deleted_slot, or for a full slot either
+        // full_slot or, under Robin Hood, the probe distance plus one.
+        static constexpr std::uint32_t empty_slot = 0;
+        static constexpr std::uint32_t full_slot = 1;
+        static constexpr std::uint32_t deleted_slot = UINT32_MAX;
+
+        struct slot_type {
+            std::uint64_t hash;
+            std::uint32_t meta = empty_slot;
+            union {
+                value_type value;
+                std::pair<Key, Value> mutable_value;
+            };
+
+            slot_type() noexcept {}
+            ~slot_type() {}
+
+            bool full() const noexcept { return meta != empty_slot && meta != deleted_slot; }
+        };
+
+        using SlotAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<slot_type>;
+        using SlotTraits = std::allocator_traits<SlotAllocator>;
+
+        std::vector<slot_type, SlotAllocator> slots;
+        std::size_t size_ = 0;
+        std::size_t tombstones = 0;
+
+        std::size_t next(std::size_t index, std::size_t step) const noexcept {
+            return Probe::next(index, step, slots.size());
+        }
+
+        void destroy_all() noexcept {
+            auto slot_alloc = slots.get_allocator();
+            for (auto& slot : slots) {
+                if (slot.full()) {
+                    SlotTraits::destroy(slot_alloc, &slot.value);
+                }
+                slot.meta = empty_slot;
+            }
+            size_ = 0;
+            tombstones = 0;
+        }
+
+        // Moves the entry of from into the empty slot to.
+        void relocate(slot_type& from, slot_type& to, std::uint32_t meta) {
+            auto slot_alloc = slots.get_allocator();
+            SlotTraits::construct(slot_alloc, &to.mutable_value, std::move(from.mutable_value));
+            SlotTraits::destroy(slot_alloc, &from.mutable_value);
+            to.hash = from.hash;
+            to.meta = meta;
+            from.meta = empty_slot;
+        }
+
+        // Slot of key, or slots.size() if it is absent.
+        template <typename K, typename KeyEqual>
+        std::size_t find_index(const K& key, std::uint64_t hash, const KeyEqual& key_eq) const noexcept {
+            auto index = Growth::index(hash, slots.size());
+            for (std::size_t step = 1;; ++step) {
+                const auto& slot = slots[index];
+                if constexpr (Probe::robin_hood) {
+                    // Every entry further on sits closer to its home than
+                    // this key would, so the key is not there.
+                    if (slot.meta < step) {
+                        return slots.size();
+                    }
+                }
+                else if (slot.meta == empty_slot) {
+                    return slots.size();
+                }
+                if (slot.full() && slot.hash == hash && key_eq(slot.value.first, key)) {
+                    return index;
+                }
+                index = next(index, step);
+            }
+        }
+
+        // Robin Hood erase: pulls the rest of the run one slot back toward
+        // home, so no tombstone is needed.
+        void close_gap(std::size_t hole) noexcept {
+            for (auto index = next(hole, 1); slots[index].meta > full_slot; index = next(index, 1)) {
+                relocate(slots[index], slots[hole], slots[index].meta - 1);
+                hole = index;
+            }
+            slots[hole].meta = empty_slot;
+        }
+
+    public:
+        template <bool IsConst>
+        class Iterator {
+            using SlotPointer = std::conditional_t<IsConst, const slot_type*, slot_type*>;
+
+            SlotPointer slot = nullptr;
+            SlotPointer end_slot = nullptr;
+
+            template <bool> friend class Iterator;
+
+            void skip_free_slots() {
+                while (slot != end_slot && !slot->full()) {
+                    ++slot;
+                }
+            }
+
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = std::pair<const Key, Value>;
+            using difference_type = std::ptrdiff_t;
+            using pointer = std::conditional_t<IsConst, const value_type*, value_type*>;
+            using reference = std::conditional_t<IsConst, const value_type&, value_type&>;
+
+            Iterator() = default;
+
+            Iterator(SlotPointer s, SlotPointer end) : slot(s), end_slot(end) {
+                skip_free_slots();
+            }
+
+            template <bool WasConst>
+                requires (IsConst && !WasConst)
+            Iterator(const Iterator<WasConst>& other)
+                : slot(other.slot), end_slot(other.end_slot) {
+            }
+
+            Iterator& operator++() {
+                ++slot;
+                skip_free_slots();
+                return *this;
+            }
+
+            Iterator operator++(int) {
+                Iterator tmp = *this;
+                ++(*this);
+                return tmp;
+            }
+
+            reference operator*() const { return slot->value; }
+            pointer operator->() const { return &slot->value; }
+
+            bool operator==(const Iterator& other) const { return slot == other.slot; }
+            bool operator!=(const Iterator& other) const { return slot != other.slot; }
+        };
+
+        using iterator = Iterator<false>;
+        using const_iterator = Iterator<true>;
+
+        open_table(std::size_t bucket_count, const Allocator& a)
+            : slots(bucket_count, SlotAllocator(a)) {
+        }
+
+        // Entries are copied into the same slots, tombstones included.
+        open_table(const open_table& other, const Allocator& a)
+            : slots(other.slots.size(), SlotAllocator(a)) {
+            auto slot_alloc = slots.get_allocator();
+            try {
+                for (std::size_t i = 0; i < slots.size(); ++i) {
+                    if (other.slots[i].full()) {
+                        SlotTraits::construct(slot_alloc, &slots[i].value, other.slots[i].value);
+                        slots[i].hash = other.slots[i].hash;
+                        slots[i].meta = other.slots[i].meta;
+                        ++size_;
+                    }
+                }
+            }
+            catch (...) {
+                destroy_all();
+                throw;
+            }
+            for (std::size_t i = 0; i < slots.size(); ++i) {
+                slots[i].meta = other.slots[i].meta;
+            }
+            tombstones = other.tombstones;
+        }
+
+        open_table(open_table&& other) noexcept
+            : slots(std::move(other.slots)),
+            size_(std::exchange(other.size_, 0)),
+            tombstones(std::exchange(other.tombstones, 0)) {
+        }
+
+        ~open_table() {
+            destroy_all();
+        }
+
+        void swap(open_table& other) noexcept {
+            slots.swap(other.slots);
+            std::swap(size_, other.size_);
+            std::swap(tombstones, other.tombstones);
+        }
+
+        template <typename K, typename KeyEqual>
+        iterator find(const K& key, std::uint64_t hash, const KeyEqual& key_eq) noexcept {
+            return iterator(slots.data() + find_index(key, hash, key_eq), slots.data() + slots.size());
+        }
+
+        template <typename... Args>
+        iterator emplace_new(std::uint64_t hash, Args&&... args) {
+            auto slot_alloc = slots.get_allocator();
+            auto index = Growth::index(hash, slots.size());
+            std::uint32_t meta = full_slot;
+
+            if constexpr (Probe::robin_hood) {
+                // Stop at the first entry closer to home than we are, then
+                // shift it and the rest of its run one slot along.
+                for (; slots[index].meta >= meta; ++meta) {
+                    index = next(index, 1);
+                }
+                if (slots[index].meta != empty_slot) {
+                    auto last = index;
+                    while (slots[last].meta != empty_slot) {
+                        last = next(last, 1);
+                    }
+                    while (last != index) {
+                        const auto prev = last == 0 ? slots.size() - 1 : last - 1;
+                        relocate(slots[prev], slots[last], slots[prev].meta + 1);
+                        last = prev;
+                    }
+                }
+                try {
+                    SlotTraits::construct(slot_alloc, &slots[index].value, std::forward<Args>(args)...);
+                }
+                catch (...) {
+                    close_gap(index);
+                    throw;
+                }
+            }
+            else {
+                for (std::size_t step = 1; slots[index].full(); ++step) {
+                    index = next(index, step);
+                }
+                SlotTraits::construct(slot_alloc, &slots[index].value, std::forward<Args>(args)...);
+                if (slots[index].meta == deleted_slot) {
+                    --tombstones;
+                }
+            }
+
+            slots[index].hash = hash;
+            slots[index].meta = meta;
+            ++size_;
+            return iterator(&slots[index], slots.data() + slots.size());
+        }
+
+        template <typename K, typename KeyEqual>
+        bool erase(const K& key, std::uint64_t hash, const KeyEqual& key_eq) noexcept {
+            const auto index = find_index(key, hash, key_eq);
+            if (index == slots.size()) {
+                return false;
+            }
+            auto& slot = slots[index];
+            auto slot_alloc = slots.get_allocator();
+            SlotTraits::destroy(slot_alloc, &slot.value);
+            --size_;
+            if constexpr (Probe::robin_hood) {
+                close_gap(index);
+            }
+            else {
+                slot.meta = deleted_slot;
+                ++tombstones;
+            }
+            return true;
+        }
+
+        void clear() noexcept {
+            destroy_all();
+        }
+
+        // Never shrinks below one free slot, whatever count is asked for.
+        template <typename HashOf>
+        void rehash(std::size_t count, HashOf&&) {
+            while (count <= size_) {
+                count = Growth::grow(count);
+            }
+            open_table fresh(count, Allocator(slots.get_allocator()));
+            for (auto& slot : slots) {
+                if (slot.full()) {
+                    fresh.emplace_new(slot.hash, std::move(slot.mutable_value));
+                }
+            }
+            swap(fresh);
+        }
+
+        // Keeps at least one slot empty so every probe terminates. When
+        // tombstones, not live entries, used up the budget, the table is
+        // rebuilt at the same size instead of grown.
+        std::size_t rehash_target(float max_load) const noexcept {
+            const auto count = slots.size();
+            const auto limit = std::min(max_load * static_cast<float>(count), static_cast<float>(count - 1));
+            if (static_cast<float>(size_ + tombstones + 1) <= limit) {
+                return 0;
+            }
+            return static_cast<float>(size_ + 1) > limit / 2 ? Growth::grow(count) : count;
+        }
+
+        void prefetch_bucket(std::uint64_t hash) const noexcept {
+            prefetch(&slots[Growth::index(hash, slots.size())]);
+        }
+
+        // The entry lives in its slot, so there is no second hop to prefetch.
+        void prefetch_chain(std::uint64_t) const noexcept {
+        }
+
+        Allocator get_allocator() const noexcept { return Allocator(slots.get_allocator()); }
+        std::size_t size() const noexcept { return size_; }
+        std::size_t bucket_count() const noexcept { return slots.size(); }
+
+        // Bucket n holds the entries whose home slot is n, wherever probing
+        // put them.
+        template <typename F>
+        void for_each_in_bucket(std::size_t n, F&& fn) const {
+            auto index = n;
+            for (std::size_t step = 1; step <= slots.size() && slots[index].meta != empty_slot; ++step) {
+                const auto& slot = slots[index];
+                if (slot.full() && Growth::index(slot.hash, slots.size()) == n) {
+                    fn(slot.value);
+                }
+                index = next(index, step);
+            }
+        }
+
+        std::size_t bucket_size(std::size_t n) const {
+            std::size_t count = 0;
+            for_each_in_bucket(n, [&](const auto&) { ++count; });
+            return count;
+        }
+
+        iterator begin() noexcept { return iterator(slots.data(), slots.data() + slots.size()); }
+        const_iterator begin() const noexcept { return const_iterator(slots.data(), slots.data() + slots.size()); }
+        iterator end() noexcept { return iterator(slots.data() + slots.size(), slots.data() + slots.size()); }
+        const_iterator end() const noexcept { return const_iterator(slots.data() + slots.size(), slots.data() + slots.size()); }
+    };
+
+} // namespace hash_map_impl
+
+// Storage policies.
+
+// One std::list per bucket. Entries never move, so references and pointers
+// to them survive rehash.
+struct chained_list {
+    template <typename Key, typename Value, typename Allocator, typename Growth>
+    using table = hash_map_impl::chained_table<Key, Value, Allocator, Growth,
+        std::list<std::pair<const Key, Value>, Allocator>>;
+};
+
+// Buckets keep their first InlineCapacity entries inline, so short chains
+// cost no allocation and no pointer chase. Entries move on rehash and erase;
+// erase needs a move that does not throw.
+template <std::size_t InlineCapacity = 2>
+struct chained_small_vector {
+    static_assert(InlineCapacity > 0);
+
+    template <typename Key, typename Value, typename Allocator, typename Growth>
+    using table = hash_map_impl::chained_table<Key, Value, Allocator, Growth,
+        hash_map_impl::chain_vector<std::pair<const Key, Value>, Allocator, InlineCapacity>>;
+};
+
+// Entries stored inline in a slot array and found by the Probe sequence:
+// hash_map_impl::linear_probing, quadratic_probing or robin_hood_probing.
+// Entries move on rehash (and, under Robin Hood, on insert and erase).
+template <typename Probe = hash_map_impl::linear_probing>
+struct open_addressing {
+    template <typename Key, typename Value, typename Allocator, typename Growth>
+    using table = hash_map_impl::open_table<Key, Value, Allocator, Growth, Probe>;
+};
+
+#endif // HASH_MAP_POLICIES_H
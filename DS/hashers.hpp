@@ -0,0 +1,240 @@
+#ifndef HASHERS_H
+#define HASHERS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// Hashers and comparators that declare is_transparent accept any key type
+// they can compare against without converting it to the container's key_type.
+template <typename T>
+concept Transparent = requires { typename T::is_transparent; };
+
+namespace hash_map_impl {
+
+    inline constexpr std::uint64_t hash_secret[4] = {
+        0xa0761d6478bd642fULL, 0xe7037ed1a0b428dbULL, 0x8ebc6af09c88c6e3ULL, 0x589965cc75374cc3ULL,
+    };
+
+    // Full 64x64->128 multiply, low half in lo and high half in hi.
+    inline void multiply_128(std::uint64_t a, std::uint64_t b, std::uint64_t& lo, std::uint64_t& hi) noexcept {
+#if defined(__SIZEOF_INT128__)
+        const auto product = static_cast<unsigned __int128>(a) * b;
+        lo = static_cast<std::uint64_t>(product);
+        hi = static_cast<std::uint64_t>(product >> 64);
+#else
+        const std::uint64_t a_lo = a & 0xffffffff, a_hi = a >> 32;
+        const std::uint64_t b_lo = b & 0xffffffff, b_hi = b >> 32;
+        const std::uint64_t lo_lo = a_lo * b_lo, hi_lo = a_hi * b_lo, lo_hi = a_lo * b_hi, hi_hi = a_hi * b_hi;
+        const std::uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xffffffff) + lo_hi;
+        lo = (cross << 32) | (lo_lo & 0xffffffff);
+        hi = hi_hi + (hi_lo >> 32) + (cross >> 32);
+#endif
+    }
+
+    // Full multiply folded back to 64 bits. One multiply mixes every input
+    // bit into the middle of the product, and the fold brings the high half
+    // down to the low bits.
+    [[nodiscard]] inline std::uint64_t fold_multiply(std::uint64_t a, std::uint64_t b) noexcept {
+        std::uint64_t lo, hi;
+        multiply_128(a, b, lo, hi);
+        return lo ^ hi;
+    }
+
+    [[nodiscard]] inline std::uint64_t read64(const char* p) noexcept {
+        std::uint64_t v;
+        std::memcpy(&v, p, sizeof v);
+        return v;
+    }
+
+    [[nodiscard]] inline std::uint64_t read32(const char* p) noexcept {
+        std::uint32_t v;
+        std::memcpy(&v, p, sizeof v);
+        return v;
+    }
+
+    // Multiply-fold hash in the style of wyhash. Inputs over 32 bytes are
+    // consumed 32 bytes per step on two independent multiply chains, so the
+    // loop runs at the multiplier's throughput rather than its latency; up to
+    // 16 bytes take two (possibly overlapping) reads and no loop at all.
+    [[nodiscard]] inline std::uint64_t hash_bytes(const char* p, std::size_t n, std::uint64_t seed = 0) noexcept {
+        const auto* k = hash_secret;
+        seed ^= fold_multiply(seed ^ k[0], k[1]);
+        std::uint64_t a = 0;
+        std::uint64_t b = 0;
+
+        if (n <= 16) {
+            if (n >= 4) {
+                const auto shift = (n >> 3) << 2;
+                a = (read32(p) << 32) | read32(p + shift);
+                b = (read32(p + n - 4) << 32) | read32(p + n - 4 - shift);
+            }
+            else if (n > 0) {
+                a = (static_cast<std::uint64_t>(static_cast<unsigned char>(p[0])) << 16) |
+                    (static_cast<std::uint64_t>(static_cast<unsigned char>(p[n >> 1])) << 8) |
+                    static_cast<unsigned char>(p[n - 1]);
+            }
+        }
+        else {
+            std::size_t i = n;
+            if (i > 32) {
+                std::uint64_t other = seed;
+                do {
+                    seed = fold_multiply(read64(p) ^ k[1], read64(p + 8) ^ seed);
+                    other = fold_multiply(read64(p + 16) ^ k[2], read64(p + 24) ^ other);
+                    p += 32;
+                    i -= 32;
+                } while (i > 32);
+                seed ^= other;
+            }
+            if (i > 16) {
+                seed = fold_multiply(read64(p) ^ k[1], read64(p + 8) ^ seed);
+                p += 16;
+                i -= 16;
+            }
+            // The last 16 bytes, overlapping what was already consumed.
+            a = read64(p + i - 16);
+            b = read64(p + i - 8);
+        }
+
+        // Each operand keeps its own bits next to the product, so input that
+        // zeroes one factor only zeroes the product, not the hash; what is
+        // left still depends on the seed and the other operand.
+        a ^= k[1];
+        b ^= seed;
+        std::uint64_t lo, hi;
+        multiply_128(a, b, lo, hi);
+        return fold_multiply(a ^ lo ^ k[0] ^ n, b ^ hi ^ k[1]);
+    }
+
+    // Finalizer of splitmix64: a bijection on 64 bits in which every input
+    // bit flips every output bit with probability close to 1/2.
+    [[nodiscard]] constexpr std::uint64_t mix_integer(std::uint64_t x) noexcept {
+        x ^= x >> 30;
+        x *= 0xbf58476d1ce4e5b9ULL;
+        x ^= x >> 27;
+        x *= 0x94d049bb133111ebULL;
+        x ^= x >> 31;
+        return x;
+    }
+
+} // namespace hash_map_impl
+
+// Hashes std::string, std::string_view and const char* through the same
+// string_view overload, so a lookup never materializes a temporary string.
+// See hash_map_impl::hash_bytes; unlike std::hash it does not walk the
+// string a byte at a time. The seeded overload lets a container pick its
+// own hash function, so keys crafted to collide under one seed do not
+// collide under another.
+struct string_hash {
+    using is_transparent = void;
+    using is_avalanching = void;
+
+    [[nodiscard]] std::size_t operator()(std::string_view s) const noexcept {
+        return static_cast<std::size_t>(hash_map_impl::hash_bytes(s.data(), s.size()));
+    }
+
+    [[nodiscard]] std::size_t operator()(std::string_view s, std::uint64_t seed) const noexcept {
+        return static_cast<std::size_t>(hash_map_impl::hash_bytes(s.data(), s.size(), seed));
+    }
+};
+
+// Integers and enums through hash_map_impl::mix_integer. std::hash is the
+// identity for these in the common standard libraries, which leaves
+// sequential or strided IDs in a handful of low-bit patterns.
+struct integer_hash {
+    using is_avalanching = void;
+
+    template <typename T>
+        requires (std::is_integral_v<T> || std::is_enum_v<T>) && (sizeof(T) <= sizeof(std::uint64_t))
+    [[nodiscard]] constexpr std::size_t operator()(T value) const noexcept {
+        return static_cast<std::size_t>(hash_map_impl::mix_integer(static_cast<std::uint64_t>(value)));
+    }
+
+    template <typename T>
+        requires (std::is_integral_v<T> || std::is_enum_v<T>) && (sizeof(T) <= sizeof(std::uint64_t))
+    [[nodiscard]] constexpr std::size_t operator()(T value, std::uint64_t seed) const noexcept {
+        return static_cast<std::size_t>(hash_map_impl::mix_integer(static_cast<std::uint64_t>(value) ^ seed));
+    }
+};
+
+// Folds the hash of another part of a composite key into seed. Not
+// commutative, so (a, b) and (b, a) hash differently. Both operands are
+// folded back in next to their product, as in hash_bytes, so a part whose
+// hash cancels the secret zeroes only the product, not the parts before it.
+[[nodiscard]] inline std::size_t hash_combine(std::size_t seed, std::size_t value) noexcept {
+    const std::uint64_t a = seed ^ hash_map_impl::hash_secret[0];
+    const std::uint64_t b = value ^ hash_map_impl::hash_secret[3];
+    std::uint64_t lo, hi;
+    hash_map_impl::multiply_128(a, b, lo, hi);
+    return static_cast<std::size_t>(lo ^ hi ^ a ^ b);
+}
+
+template <typename Key>
+struct default_hash;
+
+template <typename Key>
+using default_hash_t = typename default_hash<Key>::type;
+
+// std::pair and std::tuple keys: the default hashes of the elements,
+// chained through hash_combine. The seeded overloads start the chain from
+// the seed, so a container's seed reaches every combine.
+struct tuple_hash {
+    using is_avalanching = void;
+
+    template <typename... Ts>
+    [[nodiscard]] std::size_t operator()(const std::tuple<Ts...>& t, std::uint64_t seed = 0) const noexcept {
+        return std::apply([seed](const auto&... parts) {
+            auto h = static_cast<std::size_t>(seed ^ sizeof...(Ts));
+            ((h = hash_combine(h, default_hash_t<std::remove_cvref_t<decltype(parts)>>{}(parts))), ...);
+            return h;
+        }, t);
+    }
+
+    template <typename A, typename B>
+    [[nodiscard]] std::size_t operator()(const std::pair<A, B>& p, std::uint64_t seed = 0) const noexcept {
+        return hash_combine(hash_combine(static_cast<std::size_t>(seed ^ 2), default_hash_t<A>{}(p.first)),
+            default_hash_t<B>{}(p.second));
+    }
+};
+
+// Hasher the DS containers pick when none is given: the ones above where
+// they apply, std::hash otherwise.
+template <typename Key>
+struct default_hash {
+    using type = std::hash<Key>;
+};
+
+template <typename Key>
+    requires (std::is_integral_v<Key> || std::is_enum_v<Key>) && (sizeof(Key) <= sizeof(std::uint64_t))
+struct default_hash<Key> {
+    using type = integer_hash;
+};
+
+template <typename A, typename B>
+struct default_hash<std::pair<A, B>> {
+    using type = tuple_hash;
+};
+
+template <typename... Ts>
+struct default_hash<std::tuple<Ts...>> {
+    using type = tuple_hash;
+};
+
+template <>
+struct default_hash<std::string> {
+    using type = string_hash;
+};
+
+template <>
+struct default_hash<std::string_view> {
+    using type = string_hash;
+};
+
+#endif // HASHERS_H
@@ -0,0 +1,558 @@
+#ifndef INCREMENTAL_HASH_MAP_H
+#define INCREMENTAL_HASH_MAP_H
+
+#include <bit>
+#include <cstdint>
+#include <list>
+#include <functional>
+#include <type_traits>
+#include <utility>
+#include <initializer_list>
+#include <iostream>
+#include <memory>
+
+#include "hashers.hpp"
+
+// Chained hash map that grows without a latency spike. When an insertion
+// crosses max_load_factor the bucket array doubles, but the nodes stay where
+// they are: every later insert/erase/operator[] migrates a bounded number of
+// old buckets (migration_step) until the old array is drained.
+//
+// Buckets are selected by the top bits of the (mixed) hash, so old bucket i
+// splits into new buckets 2i and 2i+1. Those two are constructed only when
+// bucket i is migrated, which keeps the growth step itself O(1). A key whose
+// old bucket has not been migrated yet lives in the old array; lookups check
+// the old array for those buckets and the new one for the rest.
+template <typename Key, typename Value,
+    typename Hash = default_hash_t<Key>,
+    typename KeyEqual = std::equal_to<>,
+    typename Allocator = std::allocator<std::pair<const Key, Value>>>
+    requires std::is_invocable_r_v<std::size_t, const Hash&, const Key&>
+class incremental_hash_map {
+public:
+    using key_type = Key;
+    using mapped_type = Value;
+    using value_type = std::pair<const Key, Value>;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using hasher = Hash;
+    using key_equal = KeyEqual;
+    using allocator_type = Allocator;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using pointer = typename std::allocator_traits<Allocator>::pointer;
+    using const_pointer = typename std::allocator_traits<Allocator>::const_pointer;
+
+private:
+    // Migration moves nodes by their cached hash and never calls the hasher.
+    struct entry {
+        value_type value;
+        size_t hash;
+
+        template <typename... Args>
+        explicit entry(size_t h, Args&&... args)
+            : value(std::forward<Args>(args)...), hash(h) {
+        }
+    };
+
+    using EntryAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<entry>;
+    using Bucket = std::list<entry, EntryAllocator>;
+    using BucketAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Bucket>;
+    using BucketTraits = std::allocator_traits<BucketAllocator>;
+
+    Bucket* buckets = nullptr;
+    size_type bucket_count_ = 0;
+    int bucket_shift = 64;
+    Bucket* old_buckets = nullptr;
+    size_type old_bucket_count = 0;
+    size_type migrate_pos = 0;
+    size_type migration_step_ = 4;
+    Hash hash_fn;
+    KeyEqual key_eq;
+    [[no_unique_address]] Allocator alloc;
+    float max_load_factor_ = 0.75f;
+    size_type element_count = 0;
+
+    template <typename K>
+    static constexpr bool is_heterogeneous_v = std::is_same_v<K, key_type> ||
+        (Transparent<Hash> && Transparent<KeyEqual>);
+
+    static size_type normalize_bucket_count(size_type count) noexcept {
+        return std::bit_ceil(count < 2 ? size_type(2) : count);
+    }
+
+    static size_type bucket_index(size_t hash, int shift) noexcept {
+        std::uint64_t h = hash;
+        if constexpr (!requires { typename Hash::is_avalanching; }) {
+            h *= 0x9E3779B97F4A7C15ULL;
+        }
+        return static_cast<size_type>(h >> shift);
+    }
+
+    bool migrating() const noexcept { return old_buckets != nullptr; }
+
+    Bucket* allocate_buckets(size_type count) {
+        BucketAllocator bucket_alloc(alloc);
+        return BucketTraits::allocate(bucket_alloc, count);
+    }
+
+    void deallocate_buckets(Bucket* p, size_type count) noexcept {
+        BucketAllocator bucket_alloc(alloc);
+        BucketTraits::deallocate(bucket_alloc, p, count);
+    }
+
+    void construct_buckets(Bucket* p, size_type first, size_type last) {
+        BucketAllocator bucket_alloc(alloc);
+        for (auto i = first; i < last; ++i) {
+            BucketTraits::construct(bucket_alloc, p + i, EntryAllocator(alloc));
+        }
+    }
+
+    void destroy_buckets(Bucket* p, size_type first, size_type last) noexcept {
+        BucketAllocator bucket_alloc(alloc);
+        for (auto i = first; i < last; ++i) {
+            BucketTraits::destroy(bucket_alloc, p + i);
+        }
+    }
+
+    void init_table(size_type count) {
+        count = normalize_bucket_count(count);
+        buckets = allocate_buckets(count);
+        construct_buckets(buckets, 0, count);
+        bucket_count_ = count;
+        bucket_shift = 64 - std::countr_zero(count);
+    }
+
+    void release_tables() noexcept {
+        if (migrating()) {
+            destroy_buckets(old_buckets, migrate_pos, old_bucket_count);
+            deallocate_buckets(old_buckets, old_bucket_count);
+            destroy_buckets(buckets, 0, 2 * migrate_pos);
+            old_buckets = nullptr;
+            old_bucket_count = 0;
+            migrate_pos = 0;
+        }
+        else if (buckets) {
+            destroy_buckets(buckets, 0, bucket_count_);
+        }
+        if (buckets) {
+            deallocate_buckets(buckets, bucket_count_);
+        }
+        buckets = nullptr;
+        bucket_count_ = 0;
+        bucket_shift = 64;
+    }
+
+    // A moved-from map has no table; the next insertion gives it one.
+    void ensure_table() {
+        if (!buckets) {
+            init_table(16);
+        }
+    }
+
+    void migrate_one() {
+        const auto i = migrate_pos;
+        construct_buckets(buckets, 2 * i, 2 * i + 2);
+        auto& from = old_buckets[i];
+        while (!from.empty()) {
+            auto& to = buckets[bucket_index(from.front().hash, bucket_shift)];
+            to.splice(to.end(), from, from.begin());
+        }
+        destroy_buckets(old_buckets, i, i + 1);
+
+        if (++migrate_pos == old_bucket_count) {
+            deallocate_buckets(old_buckets, old_bucket_count);
+            old_buckets = nullptr;
+            old_bucket_count = 0;
+            migrate_pos = 0;
+        }
+    }
+
+    void migrate_some() {
+        for (size_type n = 0; n < migration_step_ && migrating(); ++n) {
+            migrate_one();
+        }
+    }
+
+    void finish_migration() {
+        while (migrating()) {
+            migrate_one();
+        }
+    }
+
+    // Only swaps the arrays; the nodes follow through migrate_some().
+    void start_growth() {
+        finish_migration();
+        Bucket* grown = allocate_buckets(bucket_count_ * 2);
+        old_buckets = buckets;
+        old_bucket_count = bucket_count_;
+        migrate_pos = 0;
+        buckets = grown;
+        bucket_count_ *= 2;
+        bucket_shift -= 1;
+    }
+
+    void grow_if_needed() {
+        if (load_factor() > max_load_factor_) {
+            start_growth();
+        }
+    }
+
+    // Position of a bucket in iteration order: the new buckets that were
+    // already split, followed by the old buckets still waiting for migration.
+    size_type logical_bucket_count() const noexcept {
+        return migrating() ? old_bucket_count + migrate_pos : bucket_count_;
+    }
+
+    Bucket& logical_bucket(size_type n) noexcept {
+        return (migrating() && n >= 2 * migrate_pos) ? old_buckets[n - migrate_pos] : buckets[n];
+    }
+
+    const Bucket& logical_bucket(size_type n) const noexcept {
+        return const_cast<incremental_hash_map*>(this)->logical_bucket(n);
+    }
+
+    size_type logical_index(size_t hash) const noexcept {
+        if (migrating()) {
+            const auto old_idx = bucket_index(hash, bucket_shift + 1);
+            if (old_idx >= migrate_pos) {
+                return old_idx + migrate_pos;
+            }
+        }
+        return bucket_index(hash, bucket_shift);
+    }
+
+    template <typename K>
+    typename Bucket::iterator find_in_bucket(Bucket& bucket, size_t hash, const K& key) noexcept {
+        auto it = bucket.begin();
+        while (it != bucket.end() && !(it->hash == hash && key_eq(it->value.first, key))) {
+            ++it;
+        }
+        return it;
+    }
+
+public:
+
+    template <bool IsConst>
+    class Iterator {
+        friend class incremental_hash_map;
+        template <bool> friend class Iterator;
+
+        using MapPointer = std::conditional_t<IsConst, const incremental_hash_map*, incremental_hash_map*>;
+        using BucketIterator = std::conditional_t<IsConst,
+            typename Bucket::const_iterator,
+            typename Bucket::iterator>;
+
+        MapPointer map;
+        size_type bucket;
+        BucketIterator bucket_it;
+
+        void skip_empty_buckets() {
+            const auto count = map->logical_bucket_count();
+            while (bucket < count && bucket_it == map->logical_bucket(bucket).end()) {
+                if (++bucket < count) {
+                    bucket_it = map->logical_bucket(bucket).begin();
+                }
+            }
+        }
+
+        Iterator(MapPointer m, size_type b, BucketIterator bit)
+            : map(m), bucket(b), bucket_it(bit) {
+        }
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::pair<const Key, Value>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<IsConst, const value_type*, value_type*>;
+        using reference = std::conditional_t<IsConst, const value_type&, value_type&>;
+
+        Iterator(MapPointer m, size_type b)
+            : map(m), bucket(b) {
+            if (bucket < map->logical_bucket_count()) {
+                bucket_it = map->logical_bucket(bucket).begin();
+                skip_empty_buckets();
+            }
+        }
+
+        operator Iterator<true>() const { return Iterator<true>(map, bucket, bucket_it); }
+
+        Iterator& operator++() {
+            ++bucket_it;
+            skip_empty_buckets();
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            Iterator tmp = *this;
+            ++(*this);
+            return tmp;
+        }
+
+        reference operator*() const { return bucket_it->value; }
+        pointer operator->() const { return &bucket_it->value; }
+
+        bool operator==(const Iterator& other) const {
+            return bucket == other.bucket &&
+                (bucket == map->logical_bucket_count() || bucket_it == other.bucket_it);
+        }
+
+        bool operator!=(const Iterator& other) const {
+            return !(*this == other);
+        }
+    };
+
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    explicit incremental_hash_map(size_type bucket_count = 16,
+        const Hash& hash = Hash(),
+        const KeyEqual& equal = KeyEqual(),
+        const Allocator& alloc = Allocator())
+        : hash_fn(hash), key_eq(equal), alloc(alloc) {
+        init_table(bucket_count);
+    }
+
+    incremental_hash_map(std::initializer_list<value_type> init,
+        size_type bucket_count = 16,
+        const Hash& hash = Hash(),
+        const KeyEqual& equal = KeyEqual(),
+        const Allocator& alloc = Allocator())
+        : incremental_hash_map(bucket_count, hash, equal, alloc) {
+        for (const auto& pair : init) {
+            insert(pair.first, pair.second);
+        }
+    }
+
+    // The copy is laid out as if the source had finished migrating.
+    incremental_hash_map(const incremental_hash_map& other)
+        : migration_step_(other.migration_step_),
+        hash_fn(other.hash_fn),
+        key_eq(other.key_eq),
+        alloc(std::allocator_traits<Allocator>::select_on_container_copy_construction(other.alloc)),
+        max_load_factor_(other.max_load_factor_) {
+        init_table(other.bucket_count_);
+        // The destructor does not run for a constructor that throws, so a
+        // throwing copy frees the chains built so far and the table here.
+        try {
+            for (size_type n = 0; n < other.logical_bucket_count(); ++n) {
+                for (const auto& e : other.logical_bucket(n)) {
+                    buckets[bucket_index(e.hash, bucket_shift)].emplace_back(e.hash, e.value);
+                }
+            }
+        }
+        catch (...) {
+            release_tables();
+            throw;
+        }
+        element_count = other.element_count;
+    }
+
+    incremental_hash_map(incremental_hash_map&& other) noexcept
+        : buckets(std::exchange(other.buckets, nullptr)),
+        bucket_count_(std::exchange(other.bucket_count_, 0)),
+        bucket_shift(std::exchange(other.bucket_shift, 64)),
+        old_buckets(std::exchange(other.old_buckets, nullptr)),
+        old_bucket_count(std::exchange(other.old_bucket_count, 0)),
+        migrate_pos(std::exchange(other.migrate_pos, 0)),
+        migration_step_(other.migration_step_),
+        hash_fn(std::move(other.hash_fn)),
+        key_eq(std::move(other.key_eq)),
+        alloc(std::move(other.alloc)),
+        max_load_factor_(other.max_load_factor_),
+        element_count(std::exchange(other.element_count, 0)) {
+    }
+
+    incremental_hash_map& operator=(incremental_hash_map other) noexcept {
+        swap(other);
+        return *this;
+    }
+
+    ~incremental_hash_map() {
+        release_tables();
+    }
+
+    void swap(incremental_hash_map& other) noexcept {
+        using std::swap;
+        swap(buckets, other.buckets);
+        swap(bucket_count_, other.bucket_count_);
+        swap(bucket_shift, other.bucket_shift);
+        swap(old_buckets, other.old_buckets);
+        swap(old_bucket_count, other.old_bucket_count);
+        swap(migrate_pos, other.migrate_pos);
+        swap(migration_step_, other.migration_step_);
+        swap(hash_fn, other.hash_fn);
+        swap(key_eq, other.key_eq);
+        swap(alloc, other.alloc);
+        swap(max_load_factor_, other.max_load_factor_);
+        swap(element_count, other.element_count);
+    }
+
+    [[nodiscard]] iterator begin() noexcept { return iterator(this, 0); }
+    [[nodiscard]] const_iterator begin() const noexcept { return const_iterator(this, 0); }
+    [[nodiscard]] const_iterator cbegin() const noexcept { return const_iterator(this, 0); }
+    [[nodiscard]] iterator end() noexcept { return iterator(this, logical_bucket_count()); }
+    [[nodiscard]] const_iterator end() const noexcept { return const_iterator(this, logical_bucket_count()); }
+    [[nodiscard]] const_iterator cend() const noexcept { return const_iterator(this, logical_bucket_count()); }
+
+    // Lookups never migrate, so they do not invalidate iterators.
+    template <typename K>
+    [[nodiscard]] Value* find(const K& key) noexcept {
+        if constexpr (!is_heterogeneous_v<K>) {
+            return find(Key(key));
+        }
+        else {
+            if (!buckets) {
+                return nullptr;
+            }
+            auto hash = hash_fn(key);
+            auto& bucket = logical_bucket(logical_index(hash));
+            auto it = find_in_bucket(bucket, hash, key);
+            return it != bucket.end() ? &it->value.second : nullptr;
+        }
+    }
+
+    template <typename K>
+    [[nodiscard]] const Value* find(const K& key) const noexcept {
+        return const_cast<incremental_hash_map*>(this)->find(key);
+    }
+
+    template <typename K>
+    Value& operator[](K&& key) {
+        if constexpr (!is_heterogeneous_v<std::remove_cvref_t<K>>) {
+            return (*this)[Key(std::forward<K>(key))];
+        }
+        else {
+            ensure_table();
+            migrate_some();
+            auto hash = hash_fn(key);
+            auto& bucket = logical_bucket(logical_index(hash));
+            if (auto it = find_in_bucket(bucket, hash, key); it != bucket.end()) {
+                return it->value.second;
+            }
+
+            auto& value = bucket.emplace_back(hash, std::forward<K>(key), Value()).value.second;
+            ++element_count;
+            grow_if_needed();
+            return value;
+        }
+    }
+
+    template <typename K, typename V>
+    std::pair<iterator, bool> insert(K&& key, V&& value) {
+        if constexpr (!is_heterogeneous_v<std::remove_cvref_t<K>>) {
+            return insert(Key(std::forward<K>(key)), std::forward<V>(value));
+        }
+        else {
+            ensure_table();
+            migrate_some();
+            auto hash = hash_fn(key);
+            auto idx = logical_index(hash);
+            auto& bucket = logical_bucket(idx);
+            if (auto it = find_in_bucket(bucket, hash, key); it != bucket.end()) {
+                return { iterator(this, idx, it), false };
+            }
+
+            bucket.emplace_back(hash, std::forward<K>(key), std::forward<V>(value));
+            auto node = std::prev(bucket.end());
+            ++element_count;
+            grow_if_needed();
+            return { iterator(this, logical_index(hash), node), true };
+        }
+    }
+
+    template <typename K>
+    size_type erase(const K& key) {
+        if constexpr (!is_heterogeneous_v<K>) {
+            return erase(Key(key));
+        }
+        else {
+            if (!buckets) {
+                return 0;
+            }
+            migrate_some();
+            auto hash = hash_fn(key);
+            auto& bucket = logical_bucket(logical_index(hash));
+            if (auto it = find_in_bucket(bucket, hash, key); it != bucket.end()) {
+                bucket.erase(it);
+                --element_count;
+                return 1;
+            }
+            return 0;
+        }
+    }
+
+    void clear() {
+        const auto count = bucket_count_;
+        release_tables();
+        element_count = 0;
+        if (count) {
+            init_table(count);
+        }
+    }
+
+    [[nodiscard]] size_type size() const noexcept { return element_count; }
+    [[nodiscard]] bool empty() const noexcept { return element_count == 0; }
+    [[nodiscard]] size_type bucket_count() const noexcept { return bucket_count_; }
+    [[nodiscard]] bool rehashing() const noexcept { return migrating(); }
+
+    [[nodiscard]] float load_factor() const noexcept {
+        return bucket_count_ ? static_cast<float>(element_count) / bucket_count_ : 0.0f;
+    }
+
+    [[nodiscard]] float max_load_factor() const noexcept {
+        return max_load_factor_;
+    }
+
+    void max_load_factor(float ml) {
+        max_load_factor_ = ml;
+        if (buckets) {
+            grow_if_needed();
+        }
+    }
+
+    // Old buckets moved per mutating operation while a migration is running.
+    [[nodiscard]] size_type migration_step() const noexcept {
+        return migration_step_;
+    }
+
+    void migration_step(size_type step) noexcept {
+        migration_step_ = step ? step : 1;
+    }
+
+    // Explicit rehash is not incremental: it finishes any running migration
+    // and moves every node into a table of the requested size right away.
+    void rehash(size_type count) {
+        ensure_table();
+        finish_migration();
+        Bucket* old = buckets;
+        const auto old_count = bucket_count_;
+        init_table(count);
+        for (size_type i = 0; i < old_count; ++i) {
+            while (!old[i].empty()) {
+                auto& to = buckets[bucket_index(old[i].front().hash, bucket_shift)];
+                to.splice(to.end(), old[i], old[i].begin());
+            }
+        }
+        destroy_buckets(old, 0, old_count);
+        deallocate_buckets(old, old_count);
+    }
+
+    void print(std::ostream& os = std::cout) const {
+        os << "Incremental Hash Map (size: " << size()
+            << ", buckets: " << bucket_count()
+            << ", load factor: " << load_factor()
+            << (rehashing() ? ", rehashing" : "") << ")\n";
+
+        for (const auto& item : *this) {
+            os << "  {" << item.first << ": " << item.second << "}\n";
+        }
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, const incremental_hash_map& map) {
+        map.print(os);
+        return os;
+    }
+};
+
+#endif // INCREMENTAL_HASH_MAP_H
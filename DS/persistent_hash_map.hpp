@@ -0,0 +1,641 @@
+#ifndef PERSISTENT_HASH_MAP_H
+#define PERSISTENT_HASH_MAP_H
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include "hashers.hpp"
+
+namespace hash_map_impl {
+
+    // Each trie level consumes 5 hash bits, so a node has up to 32 slots.
+    // Keys whose 64-bit hashes are equal end up together in a collision
+    // node below the last level.
+    inline constexpr unsigned hamt_bits = 5;
+    inline constexpr unsigned hamt_hash_bits = 64;
+    inline constexpr std::size_t hamt_max_depth = (hamt_hash_bits + hamt_bits - 1) / hamt_bits + 1;
+
+    [[nodiscard]] constexpr std::uint32_t hamt_bit(std::size_t hash, unsigned shift) noexcept {
+        return std::uint32_t(1) << ((static_cast<std::uint64_t>(hash) >> shift) & 31);
+    }
+
+    // Position of bit's slot among the set bits of map.
+    [[nodiscard]] constexpr std::uint32_t hamt_index(std::uint32_t map, std::uint32_t bit) noexcept {
+        return static_cast<std::uint32_t>(std::popcount(map & (bit - 1)));
+    }
+
+} // namespace hash_map_impl
+
+// Persistent hash map: a hash array mapped trie whose versions are never
+// modified. insert, insert_or_assign and erase return a new version that
+// copies only the nodes on the path to the key, at most one per level, and
+// shares every other node with the version it came from. Copying a map is a
+// reference count increment, so a snapshot costs O(1) however large the map.
+//
+// Nodes follow the CHAMP layout: a node keeps the entries that end at its
+// level inline, in slot order, and its subtries in a separate array, each
+// located by a 32-bit bitmap. A node is one allocation. Erasing keeps the
+// trie canonical by pulling single-entry subtries back into their parent,
+// so a version's shape depends only on its contents.
+//
+// Reference counts are atomic: versions that share nodes can be read,
+// copied and destroyed on different threads. As with std::shared_ptr, a
+// single map object that one thread reassigns while another copies it
+// needs outside synchronization.
+template <typename Key, typename Value,
+    typename Hash = default_hash_t<Key>,
+    typename KeyEqual = std::equal_to<>>
+    requires std::is_invocable_r_v<std::size_t, const Hash&, const Key&>
+class persistent_hash_map {
+public:
+    using key_type = Key;
+    using mapped_type = Value;
+    using value_type = std::pair<const Key, Value>;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using hasher = Hash;
+    using key_equal = KeyEqual;
+    using reference = const value_type&;
+    using const_reference = const value_type&;
+
+private:
+    // Followed in the same allocation by child_count child pointers and then
+    // entry_count entries. Collision nodes have empty bitmaps.
+    struct node {
+        std::atomic<std::uint32_t> refs{ 1 };
+        std::uint32_t datamap = 0;
+        std::uint32_t nodemap = 0;
+        std::uint32_t entry_count = 0;
+        std::uint32_t child_count = 0;
+    };
+
+    static constexpr std::size_t round_up(std::size_t n, std::size_t align) noexcept {
+        return (n + align - 1) / align * align;
+    }
+
+    static constexpr std::size_t node_align = std::max(alignof(node), alignof(value_type));
+    static constexpr std::size_t children_offset = round_up(sizeof(node), alignof(node*));
+
+    static std::size_t entries_offset(std::uint32_t child_count) noexcept {
+        return round_up(children_offset + child_count * sizeof(node*), alignof(value_type));
+    }
+
+    static node** children(const node* n) noexcept {
+        return reinterpret_cast<node**>(reinterpret_cast<std::byte*>(const_cast<node*>(n)) + children_offset);
+    }
+
+    static value_type* entries(const node* n) noexcept {
+        return reinterpret_cast<value_type*>(
+            reinterpret_cast<std::byte*>(const_cast<node*>(n)) + entries_offset(n->child_count));
+    }
+
+    static bool is_singleton(const node* n) noexcept {
+        return n->entry_count == 1 && n->child_count == 0;
+    }
+
+    static node* retain(node* n) noexcept {
+        if (n) {
+            n->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+        return n;
+    }
+
+    static void release(node* n) noexcept {
+        if (n && n->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            std::destroy_n(entries(n), n->entry_count);
+            for (std::uint32_t i = 0; i < n->child_count; ++i) {
+                release(children(n)[i]);
+            }
+            n->~node();
+            ::operator delete(static_cast<void*>(n), std::align_val_t(node_align));
+        }
+    }
+
+    // Owning reference to a node.
+    class node_ptr {
+        node* p = nullptr;
+
+    public:
+        node_ptr() noexcept = default;
+        explicit node_ptr(node* owned) noexcept : p(owned) {}
+        node_ptr(const node_ptr& other) noexcept : p(retain(other.p)) {}
+        node_ptr(node_ptr&& other) noexcept : p(std::exchange(other.p, nullptr)) {}
+
+        node_ptr& operator=(node_ptr other) noexcept {
+            std::swap(p, other.p);
+            return *this;
+        }
+
+        ~node_ptr() { release(p); }
+
+        [[nodiscard]] node* get() const noexcept { return p; }
+        [[nodiscard]] node* detach() noexcept { return std::exchange(p, nullptr); }
+        node* operator->() const noexcept { return p; }
+        explicit operator bool() const noexcept { return p != nullptr; }
+    };
+
+    static node_ptr share(node* n) noexcept {
+        return node_ptr(retain(n));
+    }
+
+    // Allocates a node and fills it: make_entry(i, p) constructs entry i at
+    // p and make_child(i) hands over child i. Entries are built first, so a
+    // throwing copy only has to unwind the entries before it.
+    template <typename MakeEntry, typename MakeChild>
+    static node_ptr build(std::uint32_t datamap, std::uint32_t nodemap,
+        std::uint32_t entry_count, std::uint32_t child_count,
+        MakeEntry&& make_entry, MakeChild&& make_child) {
+        const auto bytes = entries_offset(child_count) + entry_count * sizeof(value_type);
+        auto* n = ::new (::operator new(bytes, std::align_val_t(node_align))) node;
+        n->datamap = datamap;
+        n->nodemap = nodemap;
+        n->entry_count = entry_count;
+        n->child_count = child_count;
+
+        auto* e = entries(n);
+        std::uint32_t i = 0;
+        try {
+            for (; i < entry_count; ++i) {
+                make_entry(i, e + i);
+            }
+        }
+        catch (...) {
+            std::destroy_n(e, i);
+            n->~node();
+            ::operator delete(static_cast<void*>(n), std::align_val_t(node_align));
+            throw;
+        }
+        for (std::uint32_t j = 0; j < child_count; ++j) {
+            children(n)[j] = make_child(j).detach();
+        }
+        return node_ptr(n);
+    }
+
+    enum class edit { keep, insert, replace, erase };
+
+    // Copy of n with new bitmaps, one entry slot and one child slot edited.
+    // The edited entry is built by new_entry(p); the edited child is
+    // new_child. Everything else is copied (entries) or shared (children).
+    template <typename NewEntry>
+    static node_ptr rebuild(const node* n, std::uint32_t datamap, std::uint32_t nodemap,
+        edit entry_edit, std::uint32_t entry_idx, NewEntry&& new_entry,
+        edit child_edit = edit::keep, std::uint32_t child_idx = 0, node_ptr new_child = {}) {
+        auto resized = [](std::uint32_t count, edit e) {
+            return e == edit::insert ? count + 1 : e == edit::erase ? count - 1 : count;
+        };
+        // Index in n of the i-th slot of the copy, or -1 for the edited slot.
+        auto source = [](std::uint32_t i, edit e, std::uint32_t idx) -> std::int64_t {
+            switch (e) {
+            case edit::insert:
+                if (i == idx) {
+                    return -1;
+                }
+                return i < idx ? i : i - 1;
+            case edit::replace:
+                if (i == idx) {
+                    return -1;
+                }
+                return i;
+            case edit::erase:
+                return i < idx ? i : i + 1;
+            default:
+                return i;
+            }
+        };
+        const auto* old_entries = entries(n);
+        auto** old_children = children(n);
+        return build(datamap, nodemap, resized(n->entry_count, entry_edit), resized(n->child_count, child_edit),
+            [&](std::uint32_t i, value_type* p) {
+                if (auto from = source(i, entry_edit, entry_idx); from >= 0) {
+                    std::construct_at(p, old_entries[from]);
+                }
+                else {
+                    new_entry(p);
+                }
+            },
+            [&](std::uint32_t j) {
+                auto from = source(j, child_edit, child_idx);
+                return from >= 0 ? share(old_children[from]) : std::move(new_child);
+            });
+    }
+
+    static constexpr auto no_entry = [](auto&&...) {};
+    static constexpr auto no_child = [](std::uint32_t) { return node_ptr(); };
+
+    node_ptr root;
+    size_type element_count = 0;
+    [[no_unique_address]] Hash hash_fn;
+    [[no_unique_address]] KeyEqual key_eq;
+
+    persistent_hash_map(node_ptr root, size_type count, const Hash& hash, const KeyEqual& equal)
+        : root(std::move(root)), element_count(count), hash_fn(hash), key_eq(equal) {
+    }
+
+    template <typename K>
+    static constexpr bool is_heterogeneous_v = std::is_same_v<K, key_type> ||
+        (Transparent<Hash> && Transparent<KeyEqual>);
+
+    // Every level indexes with different bits, so all 64 have to be mixed.
+    template <typename K>
+    std::size_t hash_of(const K& key) const noexcept {
+        if constexpr (requires { typename Hash::is_avalanching; }) {
+            return static_cast<std::size_t>(hash_fn(key));
+        }
+        else {
+            return static_cast<std::size_t>(hash_map_impl::mix_integer(hash_fn(key)));
+        }
+    }
+
+    // Subtrie holding an existing entry and a new one that collided with it
+    // at the level above.
+    template <typename MakeEntry>
+    static node_ptr merge_two(const value_type& existing, std::size_t existing_hash,
+        MakeEntry& make_entry, std::size_t hash, unsigned shift) {
+        if (shift >= hash_map_impl::hamt_hash_bits) {
+            return build(0, 0, 2, 0, [&](std::uint32_t i, value_type* p) {
+                if (i == 0) {
+                    std::construct_at(p, existing);
+                }
+                else {
+                    make_entry(p);
+                }
+            }, no_child);
+        }
+        const auto existing_bit = hash_map_impl::hamt_bit(existing_hash, shift);
+        const auto bit = hash_map_impl::hamt_bit(hash, shift);
+        if (existing_bit == bit) {
+            auto child = merge_two(existing, existing_hash, make_entry, hash, shift + hash_map_impl::hamt_bits);
+            return build(0, bit, 0, 1, no_entry, [&](std::uint32_t) { return std::move(child); });
+        }
+        const bool existing_first = existing_bit < bit;
+        return build(existing_bit | bit, 0, 2, 0, [&](std::uint32_t i, value_type* p) {
+            if ((i == 0) == existing_first) {
+                std::construct_at(p, existing);
+            }
+            else {
+                make_entry(p);
+            }
+        }, no_child);
+    }
+
+    // New version of the subtrie n with key set, or an empty pointer when
+    // nothing changes (key present and assign false). make_entry builds the
+    // new entry and runs at most once, after the last use of key.
+    template <typename K, typename MakeEntry>
+    node_ptr assoc(const node* n, std::size_t hash, unsigned shift, const K& key,
+        bool assign, MakeEntry& make_entry, bool& added) const {
+        if (shift >= hash_map_impl::hamt_hash_bits) {
+            const auto* e = entries(n);
+            for (std::uint32_t i = 0; i < n->entry_count; ++i) {
+                if (key_eq(e[i].first, key)) {
+                    return assign ? rebuild(n, 0, 0, edit::replace, i, make_entry) : node_ptr();
+                }
+            }
+            added = true;
+            return rebuild(n, 0, 0, edit::insert, n->entry_count, make_entry);
+        }
+
+        const auto bit = hash_map_impl::hamt_bit(hash, shift);
+        if (n->datamap & bit) {
+            const auto idx = hash_map_impl::hamt_index(n->datamap, bit);
+            const auto& existing = entries(n)[idx];
+            if (key_eq(existing.first, key)) {
+                return assign ? rebuild(n, n->datamap, n->nodemap, edit::replace, idx, make_entry) : node_ptr();
+            }
+            added = true;
+            auto child = merge_two(existing, hash_of(existing.first), make_entry, hash, shift + hash_map_impl::hamt_bits);
+            return rebuild(n, n->datamap & ~bit, n->nodemap | bit, edit::erase, idx, no_entry,
+                edit::insert, hash_map_impl::hamt_index(n->nodemap, bit), std::move(child));
+        }
+        if (n->nodemap & bit) {
+            const auto idx = hash_map_impl::hamt_index(n->nodemap, bit);
+            auto child = assoc(children(n)[idx], hash, shift + hash_map_impl::hamt_bits, key, assign, make_entry, added);
+            if (!child) {
+                return child;
+            }
+            return rebuild(n, n->datamap, n->nodemap, edit::keep, 0, no_entry, edit::replace, idx, std::move(child));
+        }
+        added = true;
+        return rebuild(n, n->datamap | bit, n->nodemap, edit::insert, hash_map_impl::hamt_index(n->datamap, bit), make_entry);
+    }
+
+    // New version of the subtrie n without key: nullopt if key is absent, an
+    // empty pointer if the subtrie became empty. A subtrie left with a single
+    // entry is returned as is, for the parent to inline.
+    template <typename K>
+    std::optional<node_ptr> dissoc(const node* n, std::size_t hash, unsigned shift, const K& key) const {
+        if (shift >= hash_map_impl::hamt_hash_bits) {
+            const auto* e = entries(n);
+            for (std::uint32_t i = 0; i < n->entry_count; ++i) {
+                if (key_eq(e[i].first, key)) {
+                    if (n->entry_count == 1) {
+                        return node_ptr();
+                    }
+                    return rebuild(n, 0, 0, edit::erase, i, no_entry);
+                }
+            }
+            return std::nullopt;
+        }
+
+        const auto bit = hash_map_impl::hamt_bit(hash, shift);
+        if (n->datamap & bit) {
+            const auto idx = hash_map_impl::hamt_index(n->datamap, bit);
+            if (!key_eq(entries(n)[idx].first, key)) {
+                return std::nullopt;
+            }
+            if (is_singleton(n)) {
+                return node_ptr();
+            }
+            return rebuild(n, n->datamap & ~bit, n->nodemap, edit::erase, idx, no_entry);
+        }
+        if (n->nodemap & bit) {
+            const auto idx = hash_map_impl::hamt_index(n->nodemap, bit);
+            auto child = dissoc(children(n)[idx], hash, shift + hash_map_impl::hamt_bits, key);
+            if (!child) {
+                return child;
+            }
+            const bool only_child = n->entry_count == 0 && n->child_count == 1;
+            if (!*child) {
+                if (only_child) {
+                    return node_ptr();
+                }
+                return rebuild(n, n->datamap, n->nodemap & ~bit, edit::keep, 0, no_entry, edit::erase, idx);
+            }
+            if (is_singleton(child->get())) {
+                if (only_child) {
+                    return child;
+                }
+                const auto& last = entries(child->get())[0];
+                return rebuild(n, n->datamap | bit, n->nodemap & ~bit,
+                    edit::insert, hash_map_impl::hamt_index(n->datamap, bit), [&](value_type* p) { std::construct_at(p, last); },
+                    edit::erase, idx);
+            }
+            return rebuild(n, n->datamap, n->nodemap, edit::keep, 0, no_entry, edit::replace, idx, std::move(*child));
+        }
+        return std::nullopt;
+    }
+
+    template <typename K, typename V>
+    persistent_hash_map set(K&& key, V&& value, bool assign) const {
+        const auto hash = hash_of(key);
+        bool added = false;
+        auto make_entry = [&](value_type* p) {
+            std::construct_at(p, std::forward<K>(key), std::forward<V>(value));
+        };
+        node_ptr result;
+        if (root) {
+            result = assoc(root.get(), hash, 0, key, assign, make_entry, added);
+            if (!result) {
+                return *this;
+            }
+        }
+        else {
+            result = build(hash_map_impl::hamt_bit(hash, 0), 0, 1, 0,
+                [&](std::uint32_t, value_type* p) { make_entry(p); }, no_child);
+            added = true;
+        }
+        return persistent_hash_map(std::move(result), element_count + added, hash_fn, key_eq);
+    }
+
+public:
+    // Walks the trie depth first: a node's own entries, then its subtries
+    // in slot order. The iterator stays valid while any version holding the
+    // nodes it visits is alive.
+    class const_iterator {
+        friend class persistent_hash_map;
+
+        struct frame {
+            const node* n;
+            std::uint32_t entry;
+            std::uint32_t child;
+        };
+
+        frame stack[hash_map_impl::hamt_max_depth]{};
+        int depth = -1;
+
+        explicit const_iterator(const node* root) noexcept {
+            if (root) {
+                stack[++depth] = { root, 0, 0 };
+                settle();
+            }
+        }
+
+        // Moves down or up until the top frame points at an entry.
+        void settle() noexcept {
+            while (depth >= 0) {
+                auto& top = stack[depth];
+                if (top.entry < top.n->entry_count) {
+                    return;
+                }
+                if (top.child < top.n->child_count) {
+                    const node* next = children(top.n)[top.child++];
+                    stack[++depth] = { next, 0, 0 };
+                }
+                else {
+                    --depth;
+                }
+            }
+        }
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::pair<const Key, Value>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const value_type*;
+        using reference = const value_type&;
+
+        const_iterator() noexcept = default;
+
+        const_iterator& operator++() noexcept {
+            ++stack[depth].entry;
+            settle();
+            return *this;
+        }
+
+        const_iterator operator++(int) noexcept {
+            const_iterator tmp = *this;
+            ++(*this);
+            return tmp;
+        }
+
+        reference operator*() const noexcept { return entries(stack[depth].n)[stack[depth].entry]; }
+        pointer operator->() const noexcept { return &**this; }
+
+        bool operator==(const const_iterator& other) const noexcept {
+            return depth == other.depth && (depth < 0 ||
+                (stack[depth].n == other.stack[depth].n && stack[depth].entry == other.stack[depth].entry));
+        }
+
+        bool operator!=(const const_iterator& other) const noexcept {
+            return !(*this == other);
+        }
+    };
+
+    using iterator = const_iterator;
+
+    explicit persistent_hash_map(const Hash& hash = Hash(), const KeyEqual& equal = KeyEqual())
+        : hash_fn(hash), key_eq(equal) {
+    }
+
+    template <std::input_iterator It>
+        requires requires (It it) { it->first; it->second; }
+    persistent_hash_map(It first, It last,
+        const Hash& hash = Hash(),
+        const KeyEqual& equal = KeyEqual())
+        : hash_fn(hash), key_eq(equal) {
+        for (; first != last; ++first) {
+            *this = insert(first->first, first->second);
+        }
+    }
+
+    persistent_hash_map(std::initializer_list<value_type> init,
+        const Hash& hash = Hash(),
+        const KeyEqual& equal = KeyEqual())
+        : persistent_hash_map(init.begin(), init.end(), hash, equal) {
+    }
+
+    // Copies share the whole trie.
+    persistent_hash_map(const persistent_hash_map&) = default;
+    persistent_hash_map(persistent_hash_map&&) noexcept = default;
+    persistent_hash_map& operator=(const persistent_hash_map&) = default;
+    persistent_hash_map& operator=(persistent_hash_map&&) noexcept = default;
+    ~persistent_hash_map() = default;
+
+    void swap(persistent_hash_map& other) noexcept {
+        using std::swap;
+        swap(root, other.root);
+        swap(element_count, other.element_count);
+        swap(hash_fn, other.hash_fn);
+        swap(key_eq, other.key_eq);
+    }
+
+    [[nodiscard]] const_iterator begin() const noexcept { return const_iterator(root.get()); }
+    [[nodiscard]] const_iterator cbegin() const noexcept { return begin(); }
+    [[nodiscard]] const_iterator end() const noexcept { return const_iterator(); }
+    [[nodiscard]] const_iterator cend() const noexcept { return end(); }
+
+    // At most one bitmap test and popcount per level, 13 levels for 64-bit
+    // hashes; about log32(size()) in practice.
+    template <typename K>
+    [[nodiscard]] const Value* find(const K& key) const noexcept {
+        if constexpr (!is_heterogeneous_v<K>) {
+            return find(Key(key));
+        }
+        else {
+            const auto hash = hash_of(key);
+            const node* n = root.get();
+            for (unsigned shift = 0; n; shift += hash_map_impl::hamt_bits) {
+                if (shift >= hash_map_impl::hamt_hash_bits) {
+                    const auto* e = entries(n);
+                    for (std::uint32_t i = 0; i < n->entry_count; ++i) {
+                        if (key_eq(e[i].first, key)) {
+                            return &e[i].second;
+                        }
+                    }
+                    return nullptr;
+                }
+                const auto bit = hash_map_impl::hamt_bit(hash, shift);
+                if (n->datamap & bit) {
+                    const auto& entry = entries(n)[hash_map_impl::hamt_index(n->datamap, bit)];
+                    return key_eq(entry.first, key) ? &entry.second : nullptr;
+                }
+                if (!(n->nodemap & bit)) {
+                    return nullptr;
+                }
+                n = children(n)[hash_map_impl::hamt_index(n->nodemap, bit)];
+            }
+            return nullptr;
+        }
+    }
+
+    template <typename K>
+    [[nodiscard]] bool contains(const K& key) const noexcept {
+        return find(key) != nullptr;
+    }
+
+    // Version with key mapped to value; *this itself if key is present.
+    template <typename K, typename V>
+        requires std::constructible_from<Key, K>
+    [[nodiscard]] persistent_hash_map insert(K&& key, V&& value) const {
+        if constexpr (!is_heterogeneous_v<std::remove_cvref_t<K>>) {
+            return insert(Key(std::forward<K>(key)), std::forward<V>(value));
+        }
+        else {
+            return set(std::forward<K>(key), std::forward<V>(value), false);
+        }
+    }
+
+    // Version with key mapped to value, replacing any previous value.
+    template <typename K, typename V>
+        requires std::constructible_from<Key, K>
+    [[nodiscard]] persistent_hash_map insert_or_assign(K&& key, V&& value) const {
+        if constexpr (!is_heterogeneous_v<std::remove_cvref_t<K>>) {
+            return insert_or_assign(Key(std::forward<K>(key)), std::forward<V>(value));
+        }
+        else {
+            return set(std::forward<K>(key), std::forward<V>(value), true);
+        }
+    }
+
+    // Version without key; *this itself if key is absent.
+    template <typename K>
+    [[nodiscard]] persistent_hash_map erase(const K& key) const {
+        if constexpr (!is_heterogeneous_v<K>) {
+            return erase(Key(key));
+        }
+        else {
+            if (!root) {
+                return *this;
+            }
+            auto result = dissoc(root.get(), hash_of(key), 0, key);
+            if (!result) {
+                return *this;
+            }
+            // A single entry pulled up from below still carries the bitmap of
+            // its old level; at the root it is rebuilt under its own slot.
+            if (*result && is_singleton(result->get())) {
+                const auto& last = entries(result->get())[0];
+                const auto bit = hash_map_impl::hamt_bit(hash_of(last.first), 0);
+                if ((*result)->datamap != bit) {
+                    *result = build(bit, 0, 1, 0,
+                        [&](std::uint32_t, value_type* p) { std::construct_at(p, last); }, no_child);
+                }
+            }
+            return persistent_hash_map(std::move(*result), element_count - 1, hash_fn, key_eq);
+        }
+    }
+
+    [[nodiscard]] size_type size() const noexcept { return element_count; }
+    [[nodiscard]] bool empty() const noexcept { return element_count == 0; }
+
+    void clear() noexcept {
+        root = node_ptr();
+        element_count = 0;
+    }
+
+    void print(std::ostream& os = std::cout) const {
+        os << "Persistent Hash Map (size: " << size() << ")\n";
+        for (const auto& [key, value] : *this) {
+            os << "  {" << key << ": " << value << "}\n";
+        }
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, const persistent_hash_map& map) {
+        map.print(os);
+        return os;
+    }
+};
+
+#endif // PERSISTENT_HASH_MAP_H
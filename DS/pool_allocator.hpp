@@ -0,0 +1,205 @@
+#ifndef POOL_ALLOCATOR_H
+#define POOL_ALLOCATOR_H
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace hash_map_impl {
+
+    // Fixed-size node pool. Requests up to max_pooled_size bytes are rounded up
+    // to a size class and served from that class's freelist, or carved off the
+    // current slab; freed nodes go back on their freelist and are never
+    // returned to the system individually. Slabs double in size up to
+    // max_slab_size and are all freed together by release() or the destructor.
+    //
+    // Not thread-safe: every container sharing a pool must be used from one
+    // thread at a time. That also lets the allocators keep the pool alive with
+    // a plain reference count instead of a shared_ptr, so a bucket list holding
+    // one costs a pointer and copying it costs no atomic operation.
+    class node_pool {
+    public:
+        static constexpr std::size_t granularity = alignof(std::max_align_t);
+        static constexpr std::size_t max_pooled_size = 256;
+        static constexpr std::size_t class_count = max_pooled_size / granularity;
+        static constexpr std::size_t min_slab_size = 4096;
+        static constexpr std::size_t max_slab_size = 1 << 20;
+
+        node_pool() = default;
+        node_pool(const node_pool&) = delete;
+        node_pool& operator=(const node_pool&) = delete;
+
+        ~node_pool() { release(); }
+
+        static constexpr bool pooled(std::size_t bytes, std::size_t align) noexcept {
+            return bytes <= max_pooled_size && align <= granularity;
+        }
+
+        void* allocate(std::size_t bytes) {
+            auto& head = free_lists[size_class(bytes)];
+            if (head) {
+                auto* node = head;
+                head = node->next;
+                return node;
+            }
+            const auto rounded = (size_class(bytes) + 1) * granularity;
+            if (static_cast<std::size_t>(slab_end - cursor) < rounded) {
+                add_slab(rounded);
+            }
+            auto* p = cursor;
+            cursor += rounded;
+            return p;
+        }
+
+        void deallocate(void* p, std::size_t bytes) noexcept {
+            auto& head = free_lists[size_class(bytes)];
+            head = ::new (p) free_node{ head };
+        }
+
+        void add_ref() noexcept { ++refs; }
+
+        // Returns true when the last reference was dropped.
+        bool drop_ref() noexcept { return --refs == 0; }
+
+        // Frees every slab at once. Only valid when no node handed out by the
+        // pool is still in use.
+        void release() noexcept {
+            while (slabs) {
+                auto* next = slabs->next;
+                ::operator delete(static_cast<void*>(slabs), slabs->size);
+                slabs = next;
+            }
+            for (auto& head : free_lists) {
+                head = nullptr;
+            }
+            cursor = slab_end = nullptr;
+            next_slab_size = min_slab_size;
+        }
+
+    private:
+        struct free_node {
+            free_node* next;
+        };
+
+        struct alignas(granularity) slab_header {
+            slab_header* next;
+            std::size_t size;
+        };
+
+        free_node* free_lists[class_count] = {};
+        slab_header* slabs = nullptr;
+        std::byte* cursor = nullptr;
+        std::byte* slab_end = nullptr;
+        std::size_t next_slab_size = min_slab_size;
+        std::size_t refs = 1;
+
+        static constexpr std::size_t size_class(std::size_t bytes) noexcept {
+            return bytes ? (bytes - 1) / granularity : 0;
+        }
+
+        // Whatever is left of the current slab is abandoned; it is at most
+        // one node's worth of bytes.
+        void add_slab(std::size_t at_least) {
+            std::size_t size = next_slab_size;
+            while (size < at_least + sizeof(slab_header)) {
+                size *= 2;
+            }
+            auto* raw = static_cast<std::byte*>(::operator new(size));
+            slabs = ::new (raw) slab_header{ slabs, size };
+            cursor = raw + sizeof(slab_header);
+            slab_end = raw + size;
+            if (next_slab_size < max_slab_size) {
+                next_slab_size *= 2;
+            }
+        }
+    };
+
+} // namespace hash_map_impl
+
+// Allocator over a shared node_pool, meant for node-based containers such as
+// hash_map, whose buckets allocate one small list node per element.
+// Single-object allocations go to the pool; arrays and oversized types fall
+// through to operator new.
+//
+// A default-constructed allocator owns a fresh pool; copies and rebinds share
+// it and compare equal. The pool's slabs are freed when the last allocator
+// referring to it is destroyed, or earlier through release().
+template <typename T>
+class pool_allocator {
+public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    pool_allocator() : pool(new hash_map_impl::node_pool) {
+    }
+
+    pool_allocator(const pool_allocator& other) noexcept : pool(other.pool) {
+        pool->add_ref();
+    }
+
+    template <typename U>
+    pool_allocator(const pool_allocator<U>& other) noexcept : pool(other.pool) {
+        pool->add_ref();
+    }
+
+    pool_allocator& operator=(const pool_allocator& other) noexcept {
+        other.pool->add_ref();
+        drop();
+        pool = other.pool;
+        return *this;
+    }
+
+    ~pool_allocator() {
+        drop();
+    }
+
+    [[nodiscard]] T* allocate(std::size_t n) {
+        if (n == 1 && hash_map_impl::node_pool::pooled(sizeof(T), alignof(T))) {
+            return static_cast<T*>(pool->allocate(sizeof(T)));
+        }
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(alignof(T))));
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept {
+        if (n == 1 && hash_map_impl::node_pool::pooled(sizeof(T), alignof(T))) {
+            pool->deallocate(p, sizeof(T));
+        }
+        else {
+            ::operator delete(p, n * sizeof(T), std::align_val_t(alignof(T)));
+        }
+    }
+
+    // See node_pool::release.
+    void release() noexcept {
+        pool->release();
+    }
+
+    [[nodiscard]] hash_map_impl::node_pool& resource() const noexcept {
+        return *pool;
+    }
+
+    template <typename U>
+    bool operator==(const pool_allocator<U>& other) const noexcept {
+        return pool == other.pool;
+    }
+
+private:
+    template <typename U>
+    friend class pool_allocator;
+
+    hash_map_impl::node_pool* pool;
+
+    // Leaves pool null, so nothing can reach the pool after it is deleted.
+    void drop() noexcept {
+        auto* p = std::exchange(pool, nullptr);
+        if (p->drop_ref()) {
+            delete p;
+        }
+    }
+};
+
+#endif // POOL_ALLOCATOR_H
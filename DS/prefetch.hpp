@@ -0,0 +1,23 @@
+#ifndef PREFETCH_H
+#define PREFETCH_H
+
+#if defined(_MSC_VER) && !defined(__clang__) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#endif
+
+namespace hash_map_impl {
+
+    // Hints that addr will be read soon; a no-op where no intrinsic is available.
+    inline void prefetch(const void* addr) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(addr);
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+        _mm_prefetch(static_cast<const char*>(addr), _MM_HINT_T0);
+#else
+        (void)addr;
+#endif
+    }
+
+} // namespace hash_map_impl
+
+#endif // PREFETCH_H
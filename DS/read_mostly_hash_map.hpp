@@ -0,0 +1,470 @@
+#ifndef READ_MOSTLY_HASH_MAP_H
+#define READ_MOSTLY_HASH_MAP_H
+
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "hashers.hpp"
+
+namespace hash_map_impl {
+
+    // Process-wide epoch-based reclamation domain. A reader publishes the
+    // global epoch in its own slot while it is inside a read section; memory
+    // unlinked by a writer is freed once every active reader has announced a
+    // newer epoch. Entering and leaving a section is a plain store to a
+    // thread-owned cache line plus a fence: no lock and no atomic RMW.
+    class epoch_domain {
+    public:
+        struct alignas(64) reader_slot {
+            std::atomic<std::uint64_t> epoch{ 0 };
+            std::atomic<bool> in_use{ false };
+            reader_slot* next = nullptr;
+            unsigned depth = 0;
+        };
+
+        static epoch_domain& instance() {
+            static epoch_domain domain;
+            return domain;
+        }
+
+        epoch_domain(const epoch_domain&) = delete;
+        epoch_domain& operator=(const epoch_domain&) = delete;
+
+        ~epoch_domain() {
+            for (auto* slot = head.load(std::memory_order_acquire); slot;) {
+                delete std::exchange(slot, slot->next);
+            }
+        }
+
+        // The calling thread's slot, claimed on first use and handed back at thread exit.
+        reader_slot& local() {
+            struct holder {
+                reader_slot* slot;
+                holder() : slot(instance().acquire_slot()) {}
+                ~holder() { slot->in_use.store(false, std::memory_order_release); }
+            };
+            static thread_local holder h;
+            return *h.slot;
+        }
+
+        [[nodiscard]] std::uint64_t current() const noexcept {
+            return epoch.load(std::memory_order_acquire);
+        }
+
+        // Called by writers after unlinking; returns the epoch the unlinked memory belongs to.
+        std::uint64_t advance() noexcept {
+            return epoch.fetch_add(1, std::memory_order_acq_rel);
+        }
+
+        // Oldest epoch still announced by a reader, or max() if none is active.
+        [[nodiscard]] std::uint64_t min_active() const noexcept {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            auto oldest = std::numeric_limits<std::uint64_t>::max();
+            for (auto* slot = head.load(std::memory_order_acquire); slot; slot = slot->next) {
+                const auto e = slot->epoch.load(std::memory_order_acquire);
+                if (e != 0 && e < oldest) {
+                    oldest = e;
+                }
+            }
+            return oldest;
+        }
+
+    private:
+        std::atomic<std::uint64_t> epoch{ 1 };
+        std::atomic<reader_slot*> head{ nullptr };
+
+        epoch_domain() = default;
+
+        reader_slot* acquire_slot() {
+            for (auto* slot = head.load(std::memory_order_acquire); slot; slot = slot->next) {
+                bool expected = false;
+                if (!slot->in_use.load(std::memory_order_relaxed) &&
+                    slot->in_use.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+                    return slot;
+                }
+            }
+            auto* slot = new reader_slot;
+            slot->in_use.store(true, std::memory_order_relaxed);
+            slot->next = head.load(std::memory_order_relaxed);
+            while (!head.compare_exchange_weak(slot->next, slot,
+                std::memory_order_release, std::memory_order_relaxed)) {
+            }
+            return slot;
+        }
+    };
+
+    // RAII read section; nests, so callbacks may read the map again.
+    class epoch_guard {
+        epoch_domain::reader_slot& slot;
+
+    public:
+        epoch_guard() : slot(epoch_domain::instance().local()) {
+            if (slot.depth++ == 0) {
+                slot.epoch.store(epoch_domain::instance().current(), std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+            }
+        }
+
+        epoch_guard(const epoch_guard&) = delete;
+        epoch_guard& operator=(const epoch_guard&) = delete;
+
+        ~epoch_guard() {
+            if (--slot.depth == 0) {
+                slot.epoch.store(0, std::memory_order_release);
+            }
+        }
+    };
+
+} // namespace hash_map_impl
+
+// Hash map for read-mostly data such as configuration or routing tables.
+// Lookups take no lock and perform no atomic read-modify-write: they walk
+// immutable nodes published with release stores, inside an epoch guard.
+// Writers serialize on a mutex, never modify a node a reader can see
+// (an update links in a replacement node), and hand unlinked nodes and
+// replaced bucket arrays to epoch-based reclamation.
+//
+// Values are returned by copy (find) or passed to a callback (visit) because
+// a reference could outlive the read section that keeps the node alive.
+template <typename Key, typename Value,
+    typename Hash = default_hash_t<Key>,
+    typename KeyEqual = std::equal_to<>>
+    requires std::is_invocable_r_v<std::size_t, const Hash&, const Key&>
+class read_mostly_hash_map {
+public:
+    using key_type = Key;
+    using mapped_type = Value;
+    using value_type = std::pair<const Key, Value>;
+    using size_type = std::size_t;
+    using hasher = Hash;
+    using key_equal = KeyEqual;
+
+private:
+    struct node {
+        std::atomic<node*> next;
+        const size_t hash;
+        const value_type value;
+
+        template <typename... Args>
+        node(node* n, size_t h, Args&&... args)
+            : next(n), hash(h), value(std::forward<Args>(args)...) {
+        }
+    };
+
+    struct table {
+        size_type bucket_count;
+        int shift;
+        std::unique_ptr<std::atomic<node*>[]> buckets;
+
+        explicit table(size_type count)
+            : bucket_count(count),
+            shift(64 - std::countr_zero(count)),
+            buckets(new std::atomic<node*>[count]) {
+            for (size_type i = 0; i < count; ++i) {
+                buckets[i].store(nullptr, std::memory_order_relaxed);
+            }
+        }
+
+        std::atomic<node*>& bucket_for(size_t hash) const noexcept {
+            std::uint64_t h = hash;
+            if constexpr (!requires { typename Hash::is_avalanching; }) {
+                h *= 0x9E3779B97F4A7C15ULL;
+            }
+            return buckets[static_cast<size_type>(h >> shift)];
+        }
+    };
+
+    struct retired {
+        void* ptr;
+        void (*deleter)(void*);
+        std::uint64_t epoch;
+    };
+
+    std::atomic<table*> table_;
+    std::atomic<size_type> element_count{ 0 };
+    Hash hash_fn;
+    KeyEqual key_eq;
+    // Written under write_mutex, read by max_load_factor() without it.
+    std::atomic<float> max_load_factor_{ 0.75f };
+    std::mutex write_mutex;
+    std::vector<retired> retired_list;
+
+    template <typename K>
+    static constexpr bool is_heterogeneous_v = std::is_same_v<K, key_type> ||
+        (Transparent<Hash> && Transparent<KeyEqual>);
+
+    static size_type normalize_bucket_count(size_type count) noexcept {
+        return std::bit_ceil(count < 2 ? size_type(2) : count);
+    }
+
+    template <typename K>
+    const node* find_node(const K& key, size_t hash) const noexcept {
+        const table* t = table_.load(std::memory_order_acquire);
+        for (const node* n = t->bucket_for(hash).load(std::memory_order_acquire); n;
+            n = n->next.load(std::memory_order_acquire)) {
+            if (n->hash == hash && key_eq(n->value.first, key)) {
+                return n;
+            }
+        }
+        return nullptr;
+    }
+
+    // Writer side; returns the link that points at the matching node, or
+    // the null link at the end of its chain.
+    template <typename K>
+    std::atomic<node*>& find_link(table* t, const K& key, size_t hash) noexcept {
+        std::atomic<node*>* link = &t->bucket_for(hash);
+        for (node* n = link->load(std::memory_order_relaxed); n; n = link->load(std::memory_order_relaxed)) {
+            if (n->hash == hash && key_eq(n->value.first, key)) {
+                break;
+            }
+            link = &n->next;
+        }
+        return *link;
+    }
+
+    // Must be called after p is unlinked; p is freed once every reader has
+    // moved past the epoch returned by advance().
+    template <typename T>
+    void retire(T* p, std::uint64_t epoch) {
+        retired_list.push_back({ p, [](void* q) { delete static_cast<T*>(q); }, epoch });
+    }
+
+    template <typename T>
+    void retire(T* p) {
+        retire(p, hash_map_impl::epoch_domain::instance().advance());
+    }
+
+    void retire_table(table* t) {
+        const auto epoch = hash_map_impl::epoch_domain::instance().advance();
+        for (size_type i = 0; i < t->bucket_count; ++i) {
+            for (node* n = t->buckets[i].load(std::memory_order_relaxed); n;) {
+                node* next = n->next.load(std::memory_order_relaxed);
+                retire(n, epoch);
+                n = next;
+            }
+        }
+        retire(t, epoch);
+    }
+
+    static void delete_chains(table& t) noexcept {
+        for (size_type i = 0; i < t.bucket_count; ++i) {
+            for (node* n = t.buckets[i].load(std::memory_order_relaxed); n;) {
+                delete std::exchange(n, n->next.load(std::memory_order_relaxed));
+            }
+        }
+    }
+
+    void reclaim() {
+        const auto oldest = hash_map_impl::epoch_domain::instance().min_active();
+        std::erase_if(retired_list, [oldest](const retired& r) {
+            if (r.epoch < oldest) {
+                r.deleter(r.ptr);
+                return true;
+            }
+            return false;
+        });
+    }
+
+    // Builds a complete copy of the chains and swaps it in with one store,
+    // so readers see either the old table or the new one, never a mix.
+    void rehash_locked(size_type count) {
+        table* old = table_.load(std::memory_order_relaxed);
+        auto fresh = std::make_unique<table>(normalize_bucket_count(count));
+        // Owns the nodes copied so far until the table is published, so a
+        // throwing copy frees them on the way out.
+        auto delete_copies = [](table* t) { delete_chains(*t); };
+        std::unique_ptr<table, decltype(delete_copies)> copies(fresh.get(), delete_copies);
+        for (size_type i = 0; i < old->bucket_count; ++i) {
+            for (node* n = old->buckets[i].load(std::memory_order_relaxed); n;
+                n = n->next.load(std::memory_order_relaxed)) {
+                auto& head = fresh->bucket_for(n->hash);
+                head.store(new node(head.load(std::memory_order_relaxed), n->hash, n->value),
+                    std::memory_order_relaxed);
+            }
+        }
+        copies.release();
+        table_.store(fresh.release(), std::memory_order_release);
+        retire_table(old);
+        reclaim();
+    }
+
+    void grow_if_needed_locked() {
+        const table* t = table_.load(std::memory_order_relaxed);
+        if (static_cast<float>(element_count.load(std::memory_order_relaxed)) / t->bucket_count >
+            max_load_factor_.load(std::memory_order_relaxed)) {
+            rehash_locked(t->bucket_count * 2);
+        }
+    }
+
+public:
+    explicit read_mostly_hash_map(size_type bucket_count = 16,
+        const Hash& hash = Hash(),
+        const KeyEqual& equal = KeyEqual())
+        : table_(new table(normalize_bucket_count(bucket_count))), hash_fn(hash), key_eq(equal) {
+        hash_map_impl::epoch_domain::instance();
+    }
+
+    read_mostly_hash_map(const read_mostly_hash_map&) = delete;
+    read_mostly_hash_map& operator=(const read_mostly_hash_map&) = delete;
+
+    // No reader may still be inside this map when it is destroyed.
+    ~read_mostly_hash_map() {
+        table* t = table_.load(std::memory_order_relaxed);
+        delete_chains(*t);
+        delete t;
+        for (auto& r : retired_list) {
+            r.deleter(r.ptr);
+        }
+    }
+
+    template <typename K>
+    [[nodiscard]] std::optional<Value> find(const K& key) const {
+        std::optional<Value> result;
+        visit(key, [&](const Value& value) { result.emplace(value); });
+        return result;
+    }
+
+    template <typename K>
+    [[nodiscard]] bool contains(const K& key) const {
+        return visit(key, [](const Value&) {});
+    }
+
+    // Calls fn(const Value&) inside a read section; returns whether the key was found.
+    template <typename K, typename F>
+    bool visit(const K& key, F&& fn) const {
+        if constexpr (!is_heterogeneous_v<K>) {
+            return visit(Key(key), std::forward<F>(fn));
+        }
+        else {
+            const auto hash = static_cast<size_t>(hash_fn(key));
+            hash_map_impl::epoch_guard guard;
+            if (const node* n = find_node(key, hash)) {
+                std::invoke(std::forward<F>(fn), n->value.second);
+                return true;
+            }
+            return false;
+        }
+    }
+
+    // Visits every entry of the table current at the call.
+    template <typename F>
+    void for_each(F&& fn) const {
+        hash_map_impl::epoch_guard guard;
+        const table* t = table_.load(std::memory_order_acquire);
+        for (size_type i = 0; i < t->bucket_count; ++i) {
+            for (const node* n = t->buckets[i].load(std::memory_order_acquire); n;
+                n = n->next.load(std::memory_order_acquire)) {
+                std::invoke(fn, n->value.first, n->value.second);
+            }
+        }
+    }
+
+    template <typename K, typename V>
+    bool insert(K&& key, V&& value) {
+        if constexpr (!is_heterogeneous_v<std::remove_cvref_t<K>>) {
+            return insert(Key(std::forward<K>(key)), std::forward<V>(value));
+        }
+        else {
+            const auto hash = static_cast<size_t>(hash_fn(key));
+            std::lock_guard lock(write_mutex);
+            auto& link = find_link(table_.load(std::memory_order_relaxed), key, hash);
+            if (link.load(std::memory_order_relaxed)) {
+                return false;
+            }
+            link.store(new node(nullptr, hash, std::forward<K>(key), std::forward<V>(value)),
+                std::memory_order_release);
+            element_count.fetch_add(1, std::memory_order_relaxed);
+            grow_if_needed_locked();
+            return true;
+        }
+    }
+
+    // Replaces the node of an existing key, so readers see the old or the
+    // new value but never a partially written one. Returns true on insertion.
+    template <typename K, typename V>
+    bool insert_or_assign(K&& key, V&& value) {
+        if constexpr (!is_heterogeneous_v<std::remove_cvref_t<K>>) {
+            return insert_or_assign(Key(std::forward<K>(key)), std::forward<V>(value));
+        }
+        else {
+            const auto hash = static_cast<size_t>(hash_fn(key));
+            std::lock_guard lock(write_mutex);
+            auto& link = find_link(table_.load(std::memory_order_relaxed), key, hash);
+            if (node* old = link.load(std::memory_order_relaxed)) {
+                link.store(new node(old->next.load(std::memory_order_relaxed), hash,
+                    std::forward<K>(key), std::forward<V>(value)), std::memory_order_release);
+                retire(old);
+                reclaim();
+                return false;
+            }
+            link.store(new node(nullptr, hash, std::forward<K>(key), std::forward<V>(value)),
+                std::memory_order_release);
+            element_count.fetch_add(1, std::memory_order_relaxed);
+            grow_if_needed_locked();
+            return true;
+        }
+    }
+
+    template <typename K>
+    size_type erase(const K& key) {
+        if constexpr (!is_heterogeneous_v<K>) {
+            return erase(Key(key));
+        }
+        else {
+            const auto hash = static_cast<size_t>(hash_fn(key));
+            std::lock_guard lock(write_mutex);
+            auto& link = find_link(table_.load(std::memory_order_relaxed), key, hash);
+            node* old = link.load(std::memory_order_relaxed);
+            if (!old) {
+                return 0;
+            }
+            link.store(old->next.load(std::memory_order_relaxed), std::memory_order_release);
+            element_count.fetch_sub(1, std::memory_order_relaxed);
+            retire(old);
+            reclaim();
+            return 1;
+        }
+    }
+
+    void clear() {
+        std::lock_guard lock(write_mutex);
+        table* old = table_.load(std::memory_order_relaxed);
+        table_.store(new table(old->bucket_count), std::memory_order_release);
+        element_count.store(0, std::memory_order_relaxed);
+        retire_table(old);
+        reclaim();
+    }
+
+    void rehash(size_type count) {
+        std::lock_guard lock(write_mutex);
+        rehash_locked(count);
+    }
+
+    [[nodiscard]] size_type size() const noexcept { return element_count.load(std::memory_order_relaxed); }
+    [[nodiscard]] bool empty() const noexcept { return size() == 0; }
+
+    [[nodiscard]] size_type bucket_count() const noexcept {
+        hash_map_impl::epoch_guard guard;
+        return table_.load(std::memory_order_acquire)->bucket_count;
+    }
+
+    [[nodiscard]] float max_load_factor() const noexcept { return max_load_factor_.load(std::memory_order_relaxed); }
+
+    void max_load_factor(float ml) {
+        std::lock_guard lock(write_mutex);
+        max_load_factor_.store(ml, std::memory_order_relaxed);
+        grow_if_needed_locked();
+    }
+};
+
+#endif // READ_MOSTLY_HASH_MAP_H
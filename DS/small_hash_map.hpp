@@ -0,0 +1,441 @@
+#ifndef SMALL_HASH_MAP_H
+#define SMALL_HASH_MAP_H
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "hash_map.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SMALL_HASH_MAP_SSE2 1
+#endif
+
+namespace hash_map_impl {
+
+    // Integer keys compared with std::equal_to are matched against a packed
+    // copy of the inline keys, several per SIMD compare.
+    template <typename Key, typename KeyEqual>
+    inline constexpr bool simd_key_scan_v = std::is_integral_v<Key> &&
+        (sizeof(Key) == 4 || sizeof(Key) == 8) &&
+        (std::is_same_v<KeyEqual, std::equal_to<>> || std::is_same_v<KeyEqual, std::equal_to<Key>>);
+
+    struct no_key_index {};
+
+    // Bit i is set when keys[i] == key, for the first `lanes` keys.
+    template <typename Key, std::size_t Lanes>
+    std::uint32_t match_keys(const std::array<Key, Lanes>& keys, Key key) noexcept {
+        std::uint32_t mask = 0;
+#ifdef SMALL_HASH_MAP_SSE2
+        constexpr std::size_t per_vector = 16 / sizeof(Key);
+        if constexpr (sizeof(Key) == 4) {
+            const __m128i needle = _mm_set1_epi32(static_cast<int>(key));
+            for (std::size_t i = 0; i < Lanes; i += per_vector) {
+                const auto eq = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(keys.data() + i)), needle);
+                mask |= static_cast<std::uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(eq))) << i;
+            }
+        }
+        else {
+            // SSE2 has no 64-bit compare: both 32-bit halves must match.
+            const __m128i needle = _mm_set1_epi64x(static_cast<long long>(key));
+            for (std::size_t i = 0; i < Lanes; i += per_vector) {
+                const auto eq = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(keys.data() + i)), needle);
+                const auto both = _mm_and_si128(eq, _mm_shuffle_epi32(eq, _MM_SHUFFLE(2, 3, 0, 1)));
+                mask |= static_cast<std::uint32_t>(_mm_movemask_pd(_mm_castsi128_pd(both))) << i;
+            }
+        }
+#else
+        for (std::size_t i = 0; i < Lanes; ++i) {
+            mask |= static_cast<std::uint32_t>(keys[i] == key) << i;
+        }
+#endif
+        return mask;
+    }
+
+} // namespace hash_map_impl
+
+// Hash map for the common case of a handful of entries. The first N entries
+// live inline in the object and are found by a linear scan with no hashing;
+// integer keys are scanned with SIMD compares. Inserting entry N + 1 moves
+// everything into a hash_map, which is used from then on, until clear()
+// returns the map to inline mode. Construction never allocates.
+//
+// Erasing an inline entry moves the last one into its place, which
+// invalidates iterators and references to that last entry.
+template <typename Key, typename Value, std::size_t N = 8,
+    typename Hash = default_hash_t<Key>,
+    typename KeyEqual = std::equal_to<>,
+    typename Allocator = std::allocator<std::pair<const Key, Value>>>
+    requires (N > 0 && N <= 32)
+class small_hash_map {
+public:
+    using key_type = Key;
+    using mapped_type = Value;
+    using value_type = std::pair<const Key, Value>;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using hasher = Hash;
+    using key_equal = KeyEqual;
+    using allocator_type = Allocator;
+
+private:
+    using Large = hash_map<Key, Value, Hash, KeyEqual, Allocator>;
+
+    union slot_type {
+        value_type value;
+        std::pair<Key, Value> mutable_value;
+
+        slot_type() noexcept {}
+        ~slot_type() {}
+    };
+
+    static constexpr bool nothrow_move =
+        std::is_nothrow_move_constructible_v<Key> && std::is_nothrow_move_constructible_v<Value>;
+
+    static constexpr bool simd_scan = hash_map_impl::simd_key_scan_v<Key, KeyEqual>;
+    static constexpr size_type key_lanes = (N * sizeof(Key) + 15) / 16 * 16 / sizeof(Key);
+    using KeyIndex = std::conditional_t<simd_scan, std::array<Key, key_lanes>, hash_map_impl::no_key_index>;
+
+    slot_type slots[N];
+    [[no_unique_address]] KeyIndex keys{};
+    size_type inline_count = 0;
+    std::optional<Large> large;
+    [[no_unique_address]] Hash hash_fn;
+    [[no_unique_address]] KeyEqual key_eq;
+    [[no_unique_address]] Allocator alloc;
+
+    template <typename K>
+    static constexpr bool is_heterogeneous_v = std::is_same_v<K, key_type> ||
+        (Transparent<Hash> && Transparent<KeyEqual>);
+
+    // Index of the inline entry for key, or N.
+    template <typename K>
+    size_type inline_index(const K& key) const noexcept {
+        if constexpr (simd_scan && std::is_same_v<K, Key>) {
+            const auto mask = hash_map_impl::match_keys(keys, key) & ((std::uint64_t(1) << inline_count) - 1);
+            return mask ? static_cast<size_type>(std::countr_zero(mask)) : N;
+        }
+        else {
+            for (size_type i = 0; i < inline_count; ++i) {
+                if (key_eq(slots[i].value.first, key)) {
+                    return i;
+                }
+            }
+            return N;
+        }
+    }
+
+    template <typename K, typename... Args>
+    void emplace_inline(K&& key, Args&&... args) {
+        std::construct_at(&slots[inline_count].mutable_value, std::piecewise_construct,
+            std::forward_as_tuple(std::forward<K>(key)),
+            std::forward_as_tuple(std::forward<Args>(args)...));
+        if constexpr (simd_scan) {
+            keys[inline_count] = slots[inline_count].value.first;
+        }
+        ++inline_count;
+    }
+
+    void destroy_inline() noexcept {
+        for (size_type i = 0; i < inline_count; ++i) {
+            std::destroy_at(&slots[i].mutable_value);
+        }
+        inline_count = 0;
+    }
+
+    // Moves the inline entries into a freshly built hash_map.
+    void spill() {
+        Large table(std::bit_ceil(2 * N), hash_fn, key_eq, alloc);
+        for (size_type i = 0; i < inline_count; ++i) {
+            auto& item = slots[i].mutable_value;
+            table.try_emplace(std::move(item.first), std::move(item.second));
+        }
+        large.emplace(std::move(table));
+        destroy_inline();
+    }
+
+    void copy_inline_from(const small_hash_map& other) {
+        for (size_type i = 0; i < other.inline_count; ++i) {
+            const auto& item = other.slots[i].value;
+            emplace_inline(item.first, item.second);
+        }
+    }
+
+    void move_inline_from(small_hash_map& other) noexcept(nothrow_move) {
+        for (size_type i = 0; i < other.inline_count; ++i) {
+            auto& item = other.slots[i].mutable_value;
+            emplace_inline(std::move(item.first), std::move(item.second));
+        }
+        other.destroy_inline();
+    }
+
+public:
+    template <bool IsConst>
+    class Iterator {
+        using Slot = std::conditional_t<IsConst, const slot_type, slot_type>;
+        using LargeIterator = std::conditional_t<IsConst,
+            typename Large::const_iterator,
+            typename Large::iterator>;
+
+        Slot* slot = nullptr;
+        std::optional<LargeIterator> large_it;
+
+        friend class small_hash_map;
+        template <bool> friend class Iterator;
+
+        explicit Iterator(Slot* s) noexcept : slot(s) {
+        }
+
+        explicit Iterator(LargeIterator it) : large_it(it) {
+        }
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::pair<const Key, Value>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<IsConst, const value_type*, value_type*>;
+        using reference = std::conditional_t<IsConst, const value_type&, value_type&>;
+
+        Iterator() = default;
+
+        template <bool WasConst>
+            requires (IsConst && !WasConst)
+        Iterator(const Iterator<WasConst>& other)
+            : slot(other.slot) {
+            if (other.large_it) {
+                large_it.emplace(*other.large_it);
+            }
+        }
+
+        Iterator& operator++() {
+            if (large_it) {
+                ++*large_it;
+            }
+            else {
+                ++slot;
+            }
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            Iterator tmp = *this;
+            ++(*this);
+            return tmp;
+        }
+
+        reference operator*() const { return large_it ? **large_it : slot->value; }
+        pointer operator->() const { return &**this; }
+
+        bool operator==(const Iterator& other) const {
+            return slot == other.slot && large_it == other.large_it;
+        }
+
+        bool operator!=(const Iterator& other) const {
+            return !(*this == other);
+        }
+    };
+
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    explicit small_hash_map(const Hash& hash = Hash(),
+        const KeyEqual& equal = KeyEqual(),
+        const Allocator& alloc = Allocator()) noexcept
+        : hash_fn(hash), key_eq(equal), alloc(alloc) {
+    }
+
+    small_hash_map(std::initializer_list<value_type> init,
+        const Hash& hash = Hash(),
+        const KeyEqual& equal = KeyEqual(),
+        const Allocator& alloc = Allocator())
+        : small_hash_map(hash, equal, alloc) {
+        for (const auto& pair : init) {
+            try_emplace(pair.first, pair.second);
+        }
+    }
+
+    small_hash_map(const small_hash_map& other)
+        : keys(),
+        large(other.large),
+        hash_fn(other.hash_fn),
+        key_eq(other.key_eq),
+        alloc(std::allocator_traits<Allocator>::select_on_container_copy_construction(other.alloc)) {
+        // The destructor does not run for a constructor that throws, so the
+        // entries built before the failing one are destroyed here.
+        try {
+            copy_inline_from(other);
+        }
+        catch (...) {
+            destroy_inline();
+            throw;
+        }
+    }
+
+    small_hash_map(small_hash_map&& other) noexcept(nothrow_move)
+        : keys(),
+        large(std::move(other.large)),
+        hash_fn(std::move(other.hash_fn)),
+        key_eq(std::move(other.key_eq)),
+        alloc(std::move(other.alloc)) {
+        other.large.reset();
+        if constexpr (nothrow_move) {
+            move_inline_from(other);
+        }
+        else {
+            try {
+                move_inline_from(other);
+            }
+            catch (...) {
+                destroy_inline();
+                throw;
+            }
+        }
+    }
+
+    small_hash_map& operator=(small_hash_map other) noexcept(nothrow_move) {
+        destroy_inline();
+        large = std::move(other.large);
+        other.large.reset();
+        hash_fn = std::move(other.hash_fn);
+        key_eq = std::move(other.key_eq);
+        alloc = std::move(other.alloc);
+        move_inline_from(other);
+        return *this;
+    }
+
+    ~small_hash_map() {
+        destroy_inline();
+    }
+
+    [[nodiscard]] iterator begin() noexcept {
+        return large ? iterator(large->begin()) : iterator(slots);
+    }
+
+    [[nodiscard]] const_iterator begin() const noexcept {
+        return large ? const_iterator(std::as_const(*large).begin()) : const_iterator(slots);
+    }
+
+    [[nodiscard]] iterator end() noexcept {
+        return large ? iterator(large->end()) : iterator(slots + inline_count);
+    }
+
+    [[nodiscard]] const_iterator end() const noexcept {
+        return large ? const_iterator(std::as_const(*large).end()) : const_iterator(slots + inline_count);
+    }
+
+    template <typename K>
+    [[nodiscard]] Value* find(const K& key) noexcept {
+        if constexpr (!is_heterogeneous_v<K>) {
+            return find(Key(key));
+        }
+        else {
+            if (large) {
+                return large->find(key);
+            }
+            const auto i = inline_index(key);
+            return i != N ? &slots[i].value.second : nullptr;
+        }
+    }
+
+    template <typename K>
+    [[nodiscard]] const Value* find(const K& key) const noexcept {
+        return const_cast<small_hash_map*>(this)->find(key);
+    }
+
+    template <typename K>
+    [[nodiscard]] bool contains(const K& key) const noexcept {
+        return find(key) != nullptr;
+    }
+
+    template <typename K, typename... Args>
+        requires std::constructible_from<Key, K>
+    std::pair<iterator, bool> try_emplace(K&& key, Args&&... args) {
+        if constexpr (!is_heterogeneous_v<std::remove_cvref_t<K>>) {
+            return try_emplace(Key(std::forward<K>(key)), std::forward<Args>(args)...);
+        }
+        else {
+            if (!large) {
+                if (const auto i = inline_index(key); i != N) {
+                    return { iterator(slots + i), false };
+                }
+                if (inline_count < N) {
+                    emplace_inline(std::forward<K>(key), std::forward<Args>(args)...);
+                    return { iterator(slots + inline_count - 1), true };
+                }
+                spill();
+            }
+            auto [it, inserted] = large->try_emplace(std::forward<K>(key), std::forward<Args>(args)...);
+            return { iterator(it), inserted };
+        }
+    }
+
+    template <typename K, typename V>
+        requires std::constructible_from<Key, K>
+    std::pair<iterator, bool> insert(K&& key, V&& value) {
+        return try_emplace(std::forward<K>(key), std::forward<V>(value));
+    }
+
+    template <typename K, typename V>
+        requires std::constructible_from<Key, K>
+    std::pair<iterator, bool> insert_or_assign(K&& key, V&& value) {
+        auto result = try_emplace(std::forward<K>(key), std::forward<V>(value));
+        if (!result.second) {
+            result.first->second = std::forward<V>(value);
+        }
+        return result;
+    }
+
+    template <typename K>
+        requires std::constructible_from<Key, K>
+    Value& operator[](K&& key) {
+        return try_emplace(std::forward<K>(key)).first->second;
+    }
+
+    template <typename K>
+    size_type erase(const K& key) {
+        if constexpr (!is_heterogeneous_v<K>) {
+            return erase(Key(key));
+        }
+        else {
+            if (large) {
+                return large->erase(key);
+            }
+            const auto i = inline_index(key);
+            if (i == N) {
+                return 0;
+            }
+            const auto last = inline_count - 1;
+            if (i != last) {
+                auto& hole = slots[i].mutable_value;
+                std::destroy_at(&hole);
+                std::construct_at(&hole, std::move(slots[last].mutable_value));
+                if constexpr (simd_scan) {
+                    keys[i] = keys[last];
+                }
+            }
+            std::destroy_at(&slots[last].mutable_value);
+            --inline_count;
+            return 1;
+        }
+    }
+
+    // Drops all entries and any hash table, returning to inline storage.
+    void clear() noexcept {
+        destroy_inline();
+        large.reset();
+    }
+
+    [[nodiscard]] size_type size() const noexcept { return large ? large->size() : inline_count; }
+    [[nodiscard]] bool empty() const noexcept { return size() == 0; }
+    [[nodiscard]] bool is_inline() const noexcept { return !large; }
+    [[nodiscard]] static constexpr size_type inline_capacity() noexcept { return N; }
+};
+
+#endif // SMALL_HASH_MAP_H
@@ -0,0 +1,511 @@
+#ifndef SOA_HASH_MAP_H
+#define SOA_HASH_MAP_H
+
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <type_traits>
+#include <utility>
+#include <initializer_list>
+#include <iostream>
+#include <memory>
+
+#include "flat_hash_map.hpp"
+
+// Open-addressing hash map with the control bytes and probing of
+// flat_hash_map, but with keys and values in two separate arrays. A lookup
+// reads control bytes and keys only; the value array is touched once, on a
+// hit. This pays off when Value is large next to Key: a cache line holds
+// eight 8-byte keys here, where flat_hash_map fits less than one entry with
+// a 200-byte value.
+//
+// No std::pair<const Key, Value> exists in memory, so iterators yield a pair
+// of references, (key, value), by value.
+template <typename Key, typename Value,
+    typename Hash = default_hash_t<Key>,
+    typename KeyEqual = std::equal_to<>,
+    typename Allocator = std::allocator<std::pair<const Key, Value>>>
+    requires std::is_invocable_r_v<std::size_t, const Hash&, const Key&>
+class soa_hash_map {
+public:
+    using key_type = Key;
+    using mapped_type = Value;
+    using value_type = std::pair<const Key, Value>;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using hasher = Hash;
+    using key_equal = KeyEqual;
+    using allocator_type = Allocator;
+    using reference = std::pair<const Key&, Value&>;
+    using const_reference = std::pair<const Key&, const Value&>;
+
+private:
+    using ctrl_t = hash_map_impl::ctrl_t;
+
+    using KeyAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Key>;
+    using ValueAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Value>;
+    using KeyTraits = std::allocator_traits<KeyAllocator>;
+    using ValueTraits = std::allocator_traits<ValueAllocator>;
+    using table_type = hash_map_impl::ctrl_table<Allocator>;
+
+    Hash hash_fn;
+    KeyEqual key_eq;
+    [[no_unique_address]] Allocator alloc;
+    table_type table;
+    Key* keys_ = nullptr;
+    Value* values_ = nullptr;
+    size_type element_count = 0;
+
+    template <typename K>
+    static constexpr bool is_heterogeneous_v = std::is_same_v<K, key_type> ||
+        (Transparent<Hash> && Transparent<KeyEqual>);
+
+    template <typename K>
+    size_type hash_of(const K& key) const noexcept {
+        if constexpr (requires { typename Hash::is_avalanching; }) {
+            return static_cast<size_type>(hash_fn(key));
+        }
+        else {
+            return static_cast<size_type>(hash_map_impl::mix_hash(hash_fn(key)));
+        }
+    }
+
+    // Both arrays or neither: a throwing value allocation frees the keys.
+    std::pair<Key*, Value*> allocate_arrays(size_type capacity) {
+        KeyAllocator key_alloc(alloc);
+        ValueAllocator value_alloc(alloc);
+        Key* keys = KeyTraits::allocate(key_alloc, capacity);
+        Value* values = nullptr;
+        try {
+            values = ValueTraits::allocate(value_alloc, capacity);
+        }
+        catch (...) {
+            KeyTraits::deallocate(key_alloc, keys, capacity);
+            throw;
+        }
+        return { keys, values };
+    }
+
+    void deallocate_arrays(Key* keys, Value* values, size_type capacity) noexcept {
+        if (keys) {
+            KeyAllocator key_alloc(alloc);
+            ValueAllocator value_alloc(alloc);
+            KeyTraits::deallocate(key_alloc, keys, capacity);
+            ValueTraits::deallocate(value_alloc, values, capacity);
+        }
+    }
+
+    // For a map without a table.
+    void allocate_table(size_type capacity) {
+        table_type fresh(capacity, element_count, alloc);
+        const auto [keys, values] = allocate_arrays(capacity);
+        keys_ = keys;
+        values_ = values;
+        table = std::move(fresh);
+    }
+
+    void destroy_slot(size_type i) noexcept {
+        KeyAllocator key_alloc(alloc);
+        ValueAllocator value_alloc(alloc);
+        KeyTraits::destroy(key_alloc, keys_ + i);
+        ValueTraits::destroy(value_alloc, values_ + i);
+    }
+
+    void destroy_slots() noexcept {
+        if constexpr (!std::is_trivially_destructible_v<Key> || !std::is_trivially_destructible_v<Value>) {
+            for (size_type i = 0; i < table.capacity(); ++i) {
+                if (table.is_full(i)) {
+                    destroy_slot(i);
+                }
+            }
+        }
+    }
+
+    // Only the key array is read while probing.
+    template <typename K>
+    size_type find_index(const K& key, size_type hash) const noexcept {
+        return table.find(hash, [&](size_type i) { return key_eq(keys_[i], key); });
+    }
+
+    void resize(size_type new_capacity) {
+        table_type fresh(new_capacity, element_count, alloc);
+        const auto [new_keys, new_values] = allocate_arrays(new_capacity);
+
+        KeyAllocator key_alloc(alloc);
+        ValueAllocator value_alloc(alloc);
+        fresh.rebuild_from(table,
+            [&](size_type i) { return hash_of(keys_[i]); },
+            [&](size_type from, size_type to) {
+                KeyTraits::construct(key_alloc, new_keys + to, std::move(keys_[from]));
+                ValueTraits::construct(value_alloc, new_values + to, std::move(values_[from]));
+                KeyTraits::destroy(key_alloc, keys_ + from);
+                ValueTraits::destroy(value_alloc, values_ + from);
+            });
+
+        deallocate_arrays(keys_, values_, table.capacity());
+        keys_ = new_keys;
+        values_ = new_values;
+        table = std::move(fresh);
+    }
+
+    // The key is built from key_arg and the value from args, in their own
+    // arrays; a throwing value constructor leaves the slot empty.
+    template <typename K, typename KeyArg, typename... Args>
+    std::pair<size_type, bool> find_or_prepare_insert(const K& key, KeyArg&& key_arg, Args&&... args) {
+        auto hash = hash_of(key);
+        if (auto idx = find_index(key, hash); idx != table_type::npos) {
+            return { idx, false };
+        }
+        if (table.needs_growth()) {
+            resize(table.grown_capacity(element_count));
+        }
+        const auto idx = table.find_first_non_full(hash);
+        KeyAllocator key_alloc(alloc);
+        ValueAllocator value_alloc(alloc);
+        KeyTraits::construct(key_alloc, keys_ + idx, std::forward<KeyArg>(key_arg));
+        try {
+            ValueTraits::construct(value_alloc, values_ + idx, std::forward<Args>(args)...);
+        }
+        catch (...) {
+            KeyTraits::destroy(key_alloc, keys_ + idx);
+            throw;
+        }
+        table.claim(idx, hash);
+        ++element_count;
+        return { idx, true };
+    }
+
+    void erase_index(size_type idx) noexcept {
+        destroy_slot(idx);
+        --element_count;
+        table.release(idx);
+    }
+
+public:
+
+    template <bool IsConst>
+    class Iterator {
+        friend class soa_hash_map;
+
+        using ValuePointer = std::conditional_t<IsConst, const Value*, Value*>;
+
+        const ctrl_t* ctrl;
+        const Key* key;
+        ValuePointer value;
+
+        void skip_empty_slots() {
+            while (*ctrl < hash_map_impl::ctrl_sentinel) {
+                ++ctrl;
+                ++key;
+                ++value;
+            }
+        }
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::pair<const Key, Value>;
+        using difference_type = std::ptrdiff_t;
+        using reference = std::conditional_t<IsConst, std::pair<const Key&, const Value&>, std::pair<const Key&, Value&>>;
+
+        // operator-> has no entry to point at, so it returns the reference
+        // pair wrapped in an object that does.
+        struct pointer {
+            reference ref;
+            const reference* operator->() const noexcept { return &ref; }
+        };
+
+        Iterator() noexcept : ctrl(nullptr), key(nullptr), value(nullptr) {}
+
+        Iterator(const ctrl_t* c, const Key* k, ValuePointer v)
+            : ctrl(c), key(k), value(v) {
+            skip_empty_slots();
+        }
+
+        operator Iterator<true>() const noexcept { return Iterator<true>(ctrl, key, value); }
+
+        Iterator& operator++() {
+            ++ctrl;
+            ++key;
+            ++value;
+            skip_empty_slots();
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            Iterator tmp = *this;
+            ++(*this);
+            return tmp;
+        }
+
+        reference operator*() const { return reference(*key, *value); }
+        pointer operator->() const { return pointer{ **this }; }
+
+        bool operator==(const Iterator& other) const { return ctrl == other.ctrl; }
+        bool operator!=(const Iterator& other) const { return !(*this == other); }
+    };
+
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    explicit soa_hash_map(size_type bucket_count = 16,
+        const Hash& hash = Hash(),
+        const KeyEqual& equal = KeyEqual(),
+        const Allocator& alloc = Allocator())
+        : hash_fn(hash), key_eq(equal), alloc(alloc), table(alloc) {
+        allocate_table(table_type::normalize_capacity(bucket_count));
+    }
+
+    soa_hash_map(std::initializer_list<value_type> init,
+        size_type bucket_count = 16,
+        const Hash& hash = Hash(),
+        const KeyEqual& equal = KeyEqual(),
+        const Allocator& alloc = Allocator())
+        : soa_hash_map(bucket_count, hash, equal, alloc) {
+        reserve(init.size());
+        for (const auto& pair : init) {
+            insert(pair.first, pair.second);
+        }
+    }
+
+    soa_hash_map(const soa_hash_map& other)
+        : hash_fn(other.hash_fn),
+        key_eq(other.key_eq),
+        alloc(std::allocator_traits<Allocator>::select_on_container_copy_construction(other.alloc)),
+        table(alloc) {
+        if (!other.table.allocated()) {
+            return;
+        }
+        // Same capacity, so every element keeps its slot and the control
+        // bytes are copied verbatim; nothing is rehashed.
+        const auto capacity = other.table.capacity();
+        allocate_table(capacity);
+        if constexpr (std::is_trivially_copyable_v<Key> && std::is_trivially_copyable_v<Value>) {
+            std::memcpy(static_cast<void*>(keys_), other.keys_, capacity * sizeof(Key));
+            std::memcpy(static_cast<void*>(values_), other.values_, capacity * sizeof(Value));
+        }
+        else {
+            KeyAllocator key_alloc(alloc);
+            ValueAllocator value_alloc(alloc);
+            size_type i = 0;
+            bool key_only = false;
+            try {
+                for (; i < capacity; ++i) {
+                    if (other.table.is_full(i)) {
+                        KeyTraits::construct(key_alloc, keys_ + i, other.keys_[i]);
+                        key_only = true;
+                        ValueTraits::construct(value_alloc, values_ + i, other.values_[i]);
+                        key_only = false;
+                    }
+                }
+            }
+            catch (...) {
+                if (key_only) {
+                    KeyTraits::destroy(key_alloc, keys_ + i);
+                }
+                while (i-- > 0) {
+                    if (other.table.is_full(i)) {
+                        destroy_slot(i);
+                    }
+                }
+                deallocate_arrays(keys_, values_, capacity);
+                throw;
+            }
+        }
+        table.copy_from(other.table);
+        element_count = other.element_count;
+    }
+
+    soa_hash_map(soa_hash_map&& other) noexcept
+        : hash_fn(std::move(other.hash_fn)),
+        key_eq(std::move(other.key_eq)),
+        alloc(std::move(other.alloc)),
+        table(std::move(other.table)),
+        keys_(std::exchange(other.keys_, nullptr)),
+        values_(std::exchange(other.values_, nullptr)),
+        element_count(std::exchange(other.element_count, 0)) {
+    }
+
+    soa_hash_map& operator=(soa_hash_map other) noexcept {
+        swap(other);
+        return *this;
+    }
+
+    ~soa_hash_map() {
+        destroy_slots();
+        deallocate_arrays(keys_, values_, table.capacity());
+    }
+
+    void swap(soa_hash_map& other) noexcept {
+        using std::swap;
+        swap(hash_fn, other.hash_fn);
+        swap(key_eq, other.key_eq);
+        swap(alloc, other.alloc);
+        table.swap(other.table);
+        swap(keys_, other.keys_);
+        swap(values_, other.values_);
+        swap(element_count, other.element_count);
+    }
+
+    [[nodiscard]] iterator begin() noexcept {
+        return table.allocated() ? iterator(table.data(), keys_, values_) : end();
+    }
+
+    [[nodiscard]] const_iterator begin() const noexcept {
+        return table.allocated() ? const_iterator(table.data(), keys_, values_) : end();
+    }
+
+    [[nodiscard]] const_iterator cbegin() const noexcept {
+        return begin();
+    }
+
+    [[nodiscard]] iterator end() noexcept {
+        iterator it;
+        it.ctrl = table.data() + table.capacity();
+        it.key = keys_ + table.capacity();
+        it.value = values_ + table.capacity();
+        return it;
+    }
+
+    [[nodiscard]] const_iterator end() const noexcept {
+        const_iterator it;
+        it.ctrl = table.data() + table.capacity();
+        it.key = keys_ + table.capacity();
+        it.value = values_ + table.capacity();
+        return it;
+    }
+
+    [[nodiscard]] const_iterator cend() const noexcept {
+        return end();
+    }
+
+    template <typename K>
+    [[nodiscard]] Value* find(const K& key) noexcept {
+        if constexpr (!is_heterogeneous_v<K>) {
+            return find(Key(key));
+        }
+        else {
+            if (!table.allocated()) {
+                return nullptr;
+            }
+            auto idx = find_index(key, hash_of(key));
+            return idx != table_type::npos ? values_ + idx : nullptr;
+        }
+    }
+
+    template <typename K>
+    [[nodiscard]] const Value* find(const K& key) const noexcept {
+        return const_cast<soa_hash_map*>(this)->find(key);
+    }
+
+    template <typename K>
+    [[nodiscard]] bool contains(const K& key) const noexcept {
+        return find(key) != nullptr;
+    }
+
+    template <typename K>
+    Value& operator[](K&& key) {
+        if constexpr (!is_heterogeneous_v<std::remove_cvref_t<K>>) {
+            return (*this)[Key(std::forward<K>(key))];
+        }
+        else {
+            ensure_table();
+            auto [idx, inserted] = find_or_prepare_insert(key, std::forward<K>(key));
+            return values_[idx];
+        }
+    }
+
+    // Builds the value in place from args only when key is absent.
+    template <typename K, typename... Args>
+    std::pair<iterator, bool> try_emplace(K&& key, Args&&... args) {
+        if constexpr (!is_heterogeneous_v<std::remove_cvref_t<K>>) {
+            return try_emplace(Key(std::forward<K>(key)), std::forward<Args>(args)...);
+        }
+        else {
+            ensure_table();
+            auto [idx, inserted] = find_or_prepare_insert(key, std::forward<K>(key), std::forward<Args>(args)...);
+            return { iterator(table.data() + idx, keys_ + idx, values_ + idx), inserted };
+        }
+    }
+
+    template <typename K, typename V>
+    std::pair<iterator, bool> insert(K&& key, V&& value) {
+        return try_emplace(std::forward<K>(key), std::forward<V>(value));
+    }
+
+    template <typename K>
+    size_type erase(const K& key) noexcept {
+        if constexpr (!is_heterogeneous_v<K>) {
+            return erase(Key(key));
+        }
+        else {
+            if (!table.allocated()) {
+                return 0;
+            }
+            if (auto idx = find_index(key, hash_of(key)); idx != table_type::npos) {
+                erase_index(idx);
+                return 1;
+            }
+            return 0;
+        }
+    }
+
+    void clear() noexcept {
+        destroy_slots();
+        element_count = 0;
+        table.reset();
+    }
+
+    [[nodiscard]] size_type size() const noexcept { return element_count; }
+    [[nodiscard]] bool empty() const noexcept { return element_count == 0; }
+    [[nodiscard]] size_type bucket_count() const noexcept { return table.capacity(); }
+
+    [[nodiscard]] float load_factor() const noexcept {
+        return table.capacity() ? static_cast<float>(element_count) / table.capacity() : 0.0f;
+    }
+
+    [[nodiscard]] float max_load_factor() const noexcept {
+        return 7.0f / 8.0f;
+    }
+
+    void rehash(size_type count) {
+        auto capacity = table_type::normalize_capacity(count);
+        while (table_type::capacity_to_growth(capacity) < element_count) {
+            capacity = capacity * 2 + 1;
+        }
+        resize(capacity);
+    }
+
+    void reserve(size_type count) {
+        if (!table.allocated() || table_type::capacity_to_growth(table.capacity()) < count) {
+            rehash(count + count / 7);
+        }
+    }
+
+    void print(std::ostream& os = std::cout) const {
+        os << "SoA Hash Map (size: " << size()
+            << ", capacity: " << bucket_count()
+            << ", load factor: " << load_factor() << ")\n";
+
+        for (size_type i = 0; i < table.capacity(); ++i) {
+            if (table.is_full(i)) {
+                os << "  [" << i << "] {" << keys_[i] << ": " << values_[i] << "}\n";
+            }
+        }
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, const soa_hash_map& map) {
+        map.print(os);
+        return os;
+    }
+
+private:
+    // A moved-from map has no table; the next insertion gives it one.
+    void ensure_table() {
+        if (!table.allocated()) {
+            allocate_table(table_type::min_capacity);
+        }
+    }
+};
+
+#endif // SOA_HASH_MAP_H
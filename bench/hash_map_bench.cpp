@@ -0,0 +1,411 @@
+/////////////////////////////////////////////////////////////////////////////////
+// Microbenchmarks for the DS hash maps against std::unordered_map.            //
+//                                                                             //
+// Build from the repository root, one binary per chained map variant         //
+// (hash_map.hpp and hash_map_SOLID.hpp both define ::hash_map):               //
+//                                                                             //
+//   g++ -std=c++20 -O2 -DNDEBUG -I. bench/hash_map_bench.cpp -o bench_hm     //
+//   g++ -std=c++20 -O2 -DNDEBUG -I. -DBENCH_SOLID \                           //
+//       bench/hash_map_bench.cpp -o bench_solid                               //
+//                                                                             //
+// Usage: bench_hm [max_log2_size] [filter]                                    //
+//   max_log2_size  largest table is 2^n entries (default 22)                  //
+//   filter         only run containers or key types whose name contains it   //
+//                                                                             //
+// Prints one JSON object per line:                                            //
+//   {"container","key","value","size","dist","op","ns_per_op","p50","p90",   //
+//    "p99","p999"}                                                            //
+// value is u64, or value200 for a 200-byte struct, which shows what a probe  //
+// pays for values stored next to the keys it compares.                       //
+// Ops are timed in batches of 64; percentiles are over per-batch ns/op.       //
+/////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <numeric>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#ifdef BENCH_SOLID
+#include "DS/hash_map_SOLID.hpp"
+static constexpr const char* chained_name = "hash_map_SOLID";
+static constexpr const char* chained_pool_name = "hash_map_SOLID+pool";
+#else
+#include "DS/hash_map.hpp"
+static constexpr const char* chained_name = "hash_map";
+static constexpr const char* chained_pool_name = "hash_map+pool";
+#endif
+#include "DS/flat_hash_map.hpp"
+#include "DS/pool_allocator.hpp"
+#include "DS/soa_hash_map.hpp"
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+constexpr std::size_t batch = 64;
+constexpr std::size_t min_ops = 1 << 20;
+constexpr std::size_t max_lookups = 1 << 22;
+
+volatile std::uint64_t sink;
+
+const char* filter = nullptr;
+
+bool selected(const char* name) {
+    return !filter || std::strstr(name, filter);
+}
+
+std::uint64_t splitmix(std::uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+// Mapped types: a plain integer and a 200-byte record keyed by the same id.
+struct u64_values {
+    using type = std::uint64_t;
+    static constexpr const char* name = "u64";
+    static std::uint64_t id(const type& v) { return v; }
+};
+
+struct value200 {
+    std::uint64_t id = 0;
+    std::uint64_t payload[24] = {};
+
+    value200() = default;
+    value200(std::uint64_t id) : id(id) {}
+};
+
+struct value200_values {
+    using type = value200;
+    static constexpr const char* name = "value200";
+    static std::uint64_t id(const type& v) { return v.id; }
+};
+
+// Key types. make(i) is injective, so indices [0, n) are the stored keys
+// and [n, 2n) are guaranteed misses.
+struct key16 {
+    std::uint64_t a;
+    std::uint64_t b;
+
+    bool operator==(const key16&) const = default;
+};
+
+struct key16_hash {
+    std::size_t operator()(const key16& k) const noexcept {
+        return static_cast<std::size_t>(splitmix(splitmix(k.a) ^ k.b));
+    }
+};
+
+} // namespace
+
+template <>
+struct default_hash<key16> {
+    using type = key16_hash;
+};
+
+namespace {
+
+struct int_keys {
+    using type = int;
+    static constexpr const char* name = "int";
+    static type make(std::uint64_t i) { return static_cast<int>(static_cast<std::uint32_t>(i * 0x9E3779B1u)); }
+};
+
+struct key16_keys {
+    using type = key16;
+    static constexpr const char* name = "key16";
+    static type make(std::uint64_t i) { return { splitmix(i), i }; }
+};
+
+// Fits the small-string buffer of the common standard libraries.
+struct short_string_keys {
+    using type = std::string;
+    static constexpr const char* name = "string8";
+    static type make(std::uint64_t i) {
+        char buf[16];
+        std::snprintf(buf, sizeof buf, "%08x", static_cast<unsigned>(i * 0x9E3779B1u));
+        return buf;
+    }
+};
+
+// Heap-allocated, with a long common prefix so equality has work to do.
+struct long_string_keys {
+    using type = std::string;
+    static constexpr const char* name = "string48";
+    static type make(std::uint64_t i) {
+        return "/var/lib/service/shard-000/objects/" + std::to_string(splitmix(i) % 100000000) + "-" + std::to_string(i);
+    }
+};
+
+// Zipfian ranks (theta = 0.99) with the generator of Gray et al., as used by
+// YCSB; ranks are scattered over the key indices so hot keys are not also
+// the earliest inserted.
+class zipf_generator {
+    std::uint64_t n;
+    double theta = 0.99;
+    double alpha;
+    double zetan;
+    double eta;
+    double half_pow_theta;
+
+    static double zeta(std::uint64_t n, double theta) {
+        double sum = 0;
+        for (std::uint64_t i = 1; i <= n; ++i) {
+            sum += 1.0 / std::pow(static_cast<double>(i), theta);
+        }
+        return sum;
+    }
+
+public:
+    explicit zipf_generator(std::uint64_t n) : n(n) {
+        alpha = 1.0 / (1.0 - theta);
+        zetan = zeta(n, theta);
+        const double zeta2 = zeta(2, theta);
+        eta = (1.0 - std::pow(2.0 / static_cast<double>(n), 1.0 - theta)) / (1.0 - zeta2 / zetan);
+        half_pow_theta = 1.0 + std::pow(0.5, theta);
+    }
+
+    template <typename Rng>
+    std::uint64_t operator()(Rng& rng) {
+        const double u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+        const double uz = u * zetan;
+        std::uint64_t rank;
+        if (uz < 1.0) {
+            rank = 0;
+        }
+        else if (uz < half_pow_theta) {
+            rank = 1;
+        }
+        else {
+            rank = static_cast<std::uint64_t>(static_cast<double>(n) * std::pow(eta * u - eta + 1.0, alpha));
+        }
+        return splitmix(std::min(rank, n - 1)) % n;
+    }
+};
+
+// Collects per-batch ns/op samples and prints one result line.
+class recorder {
+    std::vector<double> samples;
+    double total_ns = 0;
+    std::size_t total_ops = 0;
+
+public:
+    template <typename F>
+    void time_batches(std::size_t ops, F&& op) {
+        for (std::size_t base = 0; base < ops; base += batch) {
+            const auto end = std::min(ops, base + batch);
+            const auto start = clock_type::now();
+            for (auto i = base; i < end; ++i) {
+                op(i);
+            }
+            add(clock_type::now() - start, end - base);
+        }
+    }
+
+    void add(clock_type::duration elapsed, std::size_t ops) {
+        const double ns = std::chrono::duration<double, std::nano>(elapsed).count();
+        samples.push_back(ns / static_cast<double>(ops));
+        total_ns += ns;
+        total_ops += ops;
+    }
+
+    void report(const char* container, const char* key, const char* value, std::size_t size, const char* dist, const char* op) {
+        if (samples.empty()) {
+            return;
+        }
+        std::sort(samples.begin(), samples.end());
+        auto pct = [&](double p) {
+            return samples[std::min(samples.size() - 1, static_cast<std::size_t>(p * static_cast<double>(samples.size())))];
+        };
+        std::printf("{\"container\":\"%s\",\"key\":\"%s\",\"value\":\"%s\",\"size\":%zu,\"dist\":\"%s\",\"op\":\"%s\","
+            "\"ns_per_op\":%.2f,\"p50\":%.2f,\"p90\":%.2f,\"p99\":%.2f,\"p999\":%.2f}\n",
+            container, key, value, size, dist, op,
+            total_ns / static_cast<double>(total_ops), pct(0.5), pct(0.9), pct(0.99), pct(0.999));
+        std::fflush(stdout);
+    }
+};
+
+// The DS maps return Value* from find and take (key, value) in insert;
+// std::unordered_map returns an iterator and takes a pair.
+template <typename Map, typename K>
+bool contains(Map& map, const K& key) {
+    auto result = map.find(key);
+    if constexpr (std::is_pointer_v<decltype(result)>) {
+        return result != nullptr;
+    }
+    else {
+        return result != map.end();
+    }
+}
+
+template <typename Map, typename K>
+void put(Map& map, const K& key, std::uint64_t value) {
+    if constexpr (requires { map.try_emplace(key, value); }) {
+        map.try_emplace(key, value);
+    }
+    else {
+        map.insert(key, value);
+    }
+}
+
+template <typename Map, typename Keys, typename Values>
+void run(const char* container, std::size_t n) {
+    using key_type = typename Keys::type;
+    if (!selected(container) && !selected(Keys::name) && !selected(Values::name)) {
+        return;
+    }
+
+    std::vector<key_type> keys;
+    keys.reserve(2 * n);
+    for (std::size_t i = 0; i < 2 * n; ++i) {
+        keys.push_back(Keys::make(i));
+    }
+    std::mt19937_64 rng(n);
+    std::vector<std::size_t> order(n);
+    std::iota(order.begin(), order.end(), std::size_t(0));
+    std::shuffle(order.begin(), order.end(), rng);
+
+    const std::size_t rounds = std::max<std::size_t>(1, min_ops / n);
+
+    Map map;
+    {
+        recorder r;
+        for (std::size_t round = 0; round < rounds; ++round) {
+            Map fresh;
+            r.time_batches(n, [&](std::size_t i) { put(fresh, keys[order[i]], i); });
+            if (round + 1 == rounds) {
+                map = std::move(fresh);
+            }
+        }
+        r.report(container, Keys::name, Values::name, n, "uniform", "insert");
+    }
+
+    const std::size_t lookups = std::min(max_lookups, std::max(min_ops, n));
+    std::vector<std::size_t> uniform(lookups);
+    std::vector<std::size_t> zipf(lookups);
+    zipf_generator zipf_gen(n);
+    for (std::size_t i = 0; i < lookups; ++i) {
+        uniform[i] = rng() % n;
+        zipf[i] = zipf_gen(rng);
+    }
+
+    auto lookup = [&](const char* dist, const char* op, const std::vector<std::size_t>& indices, std::size_t offset) {
+        recorder r;
+        std::uint64_t found = 0;
+        r.time_batches(lookups, [&](std::size_t i) { found += contains(map, keys[indices[i] + offset]); });
+        sink = found;
+        r.report(container, Keys::name, Values::name, n, dist, op);
+    };
+    lookup("uniform", "find_hit", uniform, 0);
+    lookup("zipf", "find_hit", zipf, 0);
+    lookup("uniform", "find_miss", uniform, n);
+    lookup("zipf", "find_miss", zipf, n);
+
+    {
+        recorder r;
+        for (std::size_t round = 0; round < rounds; ++round) {
+            std::uint64_t sum = 0;
+            const auto start = clock_type::now();
+            for (const auto& item : map) {
+                sum += Values::id(item.second);
+            }
+            r.add(clock_type::now() - start, n);
+            sink = sum;
+        }
+        r.report(container, Keys::name, Values::name, n, "uniform", "iterate");
+    }
+
+    {
+        recorder r;
+        for (std::size_t round = 0; round < rounds; ++round) {
+            const auto start = clock_type::now();
+            Map copy(map);
+            r.add(clock_type::now() - start, n);
+            sink = copy.size();
+        }
+        r.report(container, Keys::name, Values::name, n, "uniform", "copy");
+    }
+
+    {
+        recorder r;
+        for (std::size_t round = 0; round < rounds; ++round) {
+            Map copy(map);
+            const auto start = clock_type::now();
+            copy.rehash(copy.bucket_count() * 2);
+            r.add(clock_type::now() - start, n);
+        }
+        r.report(container, Keys::name, Values::name, n, "uniform", "rehash");
+    }
+
+    {
+        recorder r;
+        for (std::size_t round = 0; round < rounds; ++round) {
+            Map copy(map);
+            std::size_t erased = 0;
+            r.time_batches(n, [&](std::size_t i) { erased += copy.erase(keys[order[n - 1 - i]]); });
+            sink = erased;
+        }
+        r.report(container, Keys::name, Values::name, n, "uniform", "erase");
+    }
+
+    // Into an empty map. Maps with a pool_allocator each own a separate
+    // pool, so this also covers merging between unequal allocators, which
+    // moves entries instead of splicing nodes.
+    if constexpr (requires (Map& a) { a.merge(a); }) {
+        recorder r;
+        for (std::size_t round = 0; round < rounds; ++round) {
+            Map source(map);
+            Map target;
+            const auto start = clock_type::now();
+            target.merge(source);
+            r.add(clock_type::now() - start, n);
+            if (target.size() != n || !source.empty()) {
+                std::fprintf(stderr, "%s: merge lost entries\n", container);
+                std::exit(1);
+            }
+        }
+        r.report(container, Keys::name, Values::name, n, "uniform", "merge");
+    }
+}
+
+template <typename Keys, typename Values = u64_values>
+void run_all(std::size_t n) {
+    using key_type = typename Keys::type;
+    using key_hash = default_hash_t<key_type>;
+    using value_type = typename Values::type;
+
+    run<hash_map<key_type, value_type>, Keys, Values>(chained_name, n);
+    run<hash_map<key_type, value_type, key_hash, std::equal_to<>, pool_allocator<std::pair<const key_type, value_type>>>,
+        Keys, Values>(chained_pool_name, n);
+    run<flat_hash_map<key_type, value_type>, Keys, Values>("flat_hash_map", n);
+    run<soa_hash_map<key_type, value_type>, Keys, Values>("soa_hash_map", n);
+    run<std::unordered_map<key_type, value_type, key_hash>, Keys, Values>("std::unordered_map", n);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const int max_log2 = argc > 1 ? std::atoi(argv[1]) : 22;
+    filter = argc > 2 ? argv[2] : nullptr;
+
+    // From L1-resident up to well past a typical last-level cache.
+    for (int log2 = 10; log2 <= max_log2; log2 += 4) {
+        const std::size_t n = std::size_t(1) << log2;
+        run_all<int_keys>(n);
+        run_all<key16_keys>(n);
+        run_all<short_string_keys>(n);
+        run_all<long_string_keys>(n);
+        run_all<int_keys, value200_values>(n);
+        run_all<key16_keys, value200_values>(n);
+    }
+}
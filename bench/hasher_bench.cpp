@@ -0,0 +1,337 @@
+/////////////////////////////////////////////////////////////////////////////////
+// Quality and throughput of the DS hashers against std::hash.                 //
+//                                                                             //
+// Build from the repository root:                                             //
+//                                                                             //
+//   g++ -std=c++20 -O2 -DNDEBUG -I. bench/hasher_bench.cpp -o bench_hashers  //
+//                                                                             //
+// Usage: bench_hashers [filter]                                               //
+//   filter         only run tests or hashers whose name contains it          //
+//                                                                             //
+// Prints one JSON object per line, one of:                                    //
+//   {"test":"avalanche","hasher","input","worst_bias","mean_bias"}            //
+//     bias is |P(output bit flips) - 0.5| for one flipped input bit, over     //
+//     every (input bit, output bit) pair; 0 is ideal, 0.5 is no mixing.       //
+//   {"test":"distribution","hasher","keys","index","chi2_ratio","max_load"}   //
+//     keys hashed into 2^16 buckets by the low bits (mask) or the high bits  //
+//     (shift); chi2_ratio is chi-square over its degrees of freedom, about   //
+//     1 for a uniform hash, and max_load the fullest bucket at 4 keys each.  //
+//   {"test":"throughput","hasher","input","ns_per_hash","gb_per_s"}          //
+//   {"test":"crafted","hasher","keys","distinct","max_chain",                //
+//    "max_chain_reseeded","reseeds"}                                          //
+//     keys built so that 8 fixed bytes, or the hash of a pair's               //
+//     second part, cancel the secret they are mixed with, hashed under        //
+//     two seeds; distinct counts different hashes, ideally one per key.       //
+//     The same keys in a hash_map: its longest chain, the longest after       //
+//     reseed(), and how often the map reseeded by itself.                     //
+/////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "DS/hash_map.hpp"
+#include "DS/hashers.hpp"
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+volatile std::uint64_t sink;
+
+const char* filter = nullptr;
+
+bool selected(const char* test, const char* hasher) {
+    return !filter || std::strstr(test, filter) || std::strstr(hasher, filter);
+}
+
+struct std_integer {
+    static constexpr const char* name = "std::hash<uint64_t>";
+    std::uint64_t operator()(std::uint64_t x) const { return std::hash<std::uint64_t>{}(x); }
+};
+
+struct ds_integer {
+    static constexpr const char* name = "integer_hash";
+    std::uint64_t operator()(std::uint64_t x) const { return integer_hash{}(x); }
+};
+
+struct std_string {
+    static constexpr const char* name = "std::hash<string_view>";
+    std::uint64_t operator()(std::string_view s) const { return std::hash<std::string_view>{}(s); }
+};
+
+struct ds_string {
+    static constexpr const char* name = "string_hash";
+    std::uint64_t operator()(std::string_view s) const { return string_hash{}(s); }
+};
+
+// Flips each input bit of many random inputs and counts, per input and
+// output bit, how often the output bit changes.
+template <typename Hasher>
+void avalanche_integers(const char* input, int input_bits, std::uint64_t (*make)(std::mt19937_64&)) {
+    if (!selected("avalanche", Hasher::name)) {
+        return;
+    }
+    constexpr int trials = 1 << 14;
+    std::vector<std::uint32_t> flips(static_cast<std::size_t>(input_bits) * 64);
+    std::mt19937_64 rng(42);
+    Hasher hash;
+    for (int t = 0; t < trials; ++t) {
+        const auto x = make(rng);
+        const auto h = hash(x);
+        for (int i = 0; i < input_bits; ++i) {
+            auto diff = h ^ hash(x ^ (std::uint64_t(1) << i));
+            for (int o = 0; o < 64; ++o, diff >>= 1) {
+                flips[static_cast<std::size_t>(i) * 64 + o] += diff & 1;
+            }
+        }
+    }
+    double worst = 0;
+    double sum = 0;
+    for (auto count : flips) {
+        const double bias = std::abs(static_cast<double>(count) / trials - 0.5);
+        worst = std::max(worst, bias);
+        sum += bias;
+    }
+    std::printf("{\"test\":\"avalanche\",\"hasher\":\"%s\",\"input\":\"%s\",\"worst_bias\":%.4f,\"mean_bias\":%.4f}\n",
+        Hasher::name, input, worst, sum / static_cast<double>(flips.size()));
+}
+
+template <typename Hasher>
+void avalanche_strings(std::size_t length) {
+    if (!selected("avalanche", Hasher::name)) {
+        return;
+    }
+    constexpr int trials = 1 << 12;
+    const auto input_bits = length * 8;
+    std::vector<std::uint32_t> flips(input_bits * 64);
+    std::mt19937_64 rng(42);
+    std::string s(length, '\0');
+    Hasher hash;
+    for (int t = 0; t < trials; ++t) {
+        for (auto& c : s) {
+            c = static_cast<char>(rng());
+        }
+        const auto h = hash(s);
+        for (std::size_t i = 0; i < input_bits; ++i) {
+            s[i / 8] ^= static_cast<char>(1 << (i % 8));
+            auto diff = h ^ hash(s);
+            s[i / 8] ^= static_cast<char>(1 << (i % 8));
+            for (int o = 0; o < 64; ++o, diff >>= 1) {
+                flips[i * 64 + o] += diff & 1;
+            }
+        }
+    }
+    double worst = 0;
+    double sum = 0;
+    for (auto count : flips) {
+        const double bias = std::abs(static_cast<double>(count) / trials - 0.5);
+        worst = std::max(worst, bias);
+        sum += bias;
+    }
+    std::printf("{\"test\":\"avalanche\",\"hasher\":\"%s\",\"input\":\"string%zu\",\"worst_bias\":%.4f,\"mean_bias\":%.4f}\n",
+        Hasher::name, length, worst, sum / static_cast<double>(flips.size()));
+}
+
+// Structured key sets as they show up in practice: dense IDs, IDs with a
+// stride that is a multiple of the bucket count, values that differ only
+// in their high bits, and numbered strings.
+template <typename Hasher, typename MakeKey>
+void distribution(const char* keys, MakeKey make) {
+    if (!selected("distribution", Hasher::name)) {
+        return;
+    }
+    constexpr int bucket_bits = 16;
+    constexpr std::size_t buckets = std::size_t(1) << bucket_bits;
+    constexpr std::size_t n = buckets * 4;
+    Hasher hash;
+
+    std::vector<std::uint64_t> hashes(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        hashes[i] = hash(make(i));
+    }
+
+    auto report = [&](const char* index, auto bucket_of) {
+        std::vector<std::uint32_t> load(buckets);
+        for (auto h : hashes) {
+            ++load[bucket_of(h)];
+        }
+        const double expected = static_cast<double>(n) / buckets;
+        double chi2 = 0;
+        for (auto l : load) {
+            chi2 += (l - expected) * (l - expected) / expected;
+        }
+        std::printf("{\"test\":\"distribution\",\"hasher\":\"%s\",\"keys\":\"%s\",\"index\":\"%s\","
+            "\"chi2_ratio\":%.3f,\"max_load\":%u}\n",
+            Hasher::name, keys, index, chi2 / (buckets - 1), *std::max_element(load.begin(), load.end()));
+    };
+    report("mask", [](std::uint64_t h) { return static_cast<std::size_t>(h & (buckets - 1)); });
+    report("shift", [](std::uint64_t h) { return static_cast<std::size_t>(h >> (64 - bucket_bits)); });
+}
+
+template <typename Hasher, typename Input>
+void throughput(const char* input, const std::vector<Input>& inputs, std::size_t bytes_each) {
+    if (!selected("throughput", Hasher::name)) {
+        return;
+    }
+    Hasher hash;
+    const std::size_t rounds = std::max<std::size_t>(1, (std::size_t(1) << 26) / (inputs.size() * (bytes_each + 8)));
+    std::uint64_t acc = 0;
+    const auto start = clock_type::now();
+    for (std::size_t r = 0; r < rounds; ++r) {
+        for (const auto& x : inputs) {
+            acc += hash(x);
+        }
+    }
+    const double ns = std::chrono::duration<double, std::nano>(clock_type::now() - start).count();
+    sink = acc;
+    const double hashes = static_cast<double>(rounds * inputs.size());
+    std::printf("{\"test\":\"throughput\",\"hasher\":\"%s\",\"input\":\"%s\",\"ns_per_hash\":%.2f,\"gb_per_s\":%.2f}\n",
+        Hasher::name, input, ns / hashes, hashes * static_cast<double>(bytes_each) / ns);
+    std::fflush(stdout);
+}
+
+template <typename Hasher>
+void string_throughput() {
+    std::mt19937_64 rng(7);
+    for (std::size_t length : { 4, 8, 16, 32, 64, 256, 1024, 16384 }) {
+        std::vector<std::string> inputs(std::max<std::size_t>(16, (std::size_t(1) << 16) / length));
+        for (auto& s : inputs) {
+            s.resize(length);
+            for (auto& c : s) {
+                c = static_cast<char>('a' + rng() % 26);
+            }
+        }
+        const auto name = "string" + std::to_string(length);
+        throughput<Hasher>(name.c_str(), inputs, length);
+    }
+}
+
+// Strings of the given length whose 8 bytes at offset equal the secret word
+// hash_bytes XORs them with, followed by a counter.
+std::vector<std::string> crafted_keys(std::size_t length, std::size_t offset, std::size_t count) {
+    std::vector<std::string> keys(count, std::string(length, 'x'));
+    for (std::size_t i = 0; i < count; ++i) {
+        std::memcpy(keys[i].data() + offset, &hash_map_impl::hash_secret[1], 8);
+        const auto tail = static_cast<std::uint32_t>(i);
+        std::memcpy(keys[i].data() + length - 4, &tail, 4);
+    }
+    return keys;
+}
+
+// For 9 to 16 bytes the first read covers bytes 0..3 and 4..7, stored as
+// high and low halves.
+std::vector<std::string> crafted_short_keys(std::size_t count) {
+    auto keys = crafted_keys(12, 0, count);
+    const auto secret = hash_map_impl::hash_secret[1];
+    const auto high = static_cast<std::uint32_t>(secret >> 32), low = static_cast<std::uint32_t>(secret);
+    for (auto& key : keys) {
+        std::memcpy(key.data(), &high, 4);
+        std::memcpy(key.data() + 4, &low, 4);
+    }
+    return keys;
+}
+
+// Pairs (i, x) where integer_hash(x) equals the secret word hash_combine
+// XORs the second part with. x is found by inverting mix_integer.
+std::vector<std::pair<long, std::uint64_t>> crafted_pair_keys(std::size_t count) {
+    auto unshift = [](std::uint64_t y, int shift) {
+        auto x = y;
+        for (int i = 0; i < 64 / shift; ++i) {
+            x = y ^ (x >> shift);
+        }
+        return x;
+    };
+    auto x = unshift(hash_map_impl::hash_secret[3], 31);
+    x *= 0x319642b2d24d8ec3ULL;
+    x = unshift(x, 27);
+    x *= 0x96de1b173f119089ULL;
+    x = unshift(x, 30);
+
+    std::vector<std::pair<long, std::uint64_t>> keys;
+    for (std::size_t i = 0; i < count; ++i) {
+        keys.emplace_back(static_cast<long>(i), x);
+    }
+    return keys;
+}
+
+template <typename Hasher, typename Key>
+void crafted(const char* hasher_name, const char* keys_name, const std::vector<Key>& keys) {
+    if (!selected("crafted", hasher_name)) {
+        return;
+    }
+    std::vector<std::uint64_t> hashes;
+    for (std::uint64_t seed : { 1, 2 }) {
+        for (const auto& key : keys) {
+            hashes.push_back(Hasher{}(key, seed));
+        }
+    }
+    std::sort(hashes.begin(), hashes.end());
+    const auto distinct = std::unique(hashes.begin(), hashes.end()) - hashes.begin();
+
+    // Chains stay bounded only if a new seed actually separates the keys.
+    hash_map<Key, int, Hasher> map;
+    for (const auto& key : keys) {
+        map[key] = 0;
+    }
+    const auto stats = map.stats();
+    map.reseed(map.seed() + 1);
+    std::printf("{\"test\":\"crafted\",\"hasher\":\"%s\",\"keys\":\"%s\",\"distinct\":%td,"
+        "\"max_chain\":%zu,\"max_chain_reseeded\":%zu,\"reseeds\":%llu}\n",
+        hasher_name, keys_name, distinct, stats.max_chain_length, map.stats().max_chain_length,
+        static_cast<unsigned long long>(stats.reseed_count));
+}
+
+std::string numbered(std::size_t i) {
+    return "user:" + std::to_string(i);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    filter = argc > 1 ? argv[1] : nullptr;
+
+    auto random64 = [](std::mt19937_64& rng) -> std::uint64_t { return rng(); };
+    auto small_id = [](std::mt19937_64& rng) -> std::uint64_t { return rng() & 0xffff; };
+    avalanche_integers<std_integer>("random64", 64, random64);
+    avalanche_integers<ds_integer>("random64", 64, random64);
+    avalanche_integers<std_integer>("id16", 16, small_id);
+    avalanche_integers<ds_integer>("id16", 16, small_id);
+    for (std::size_t length : { 3, 8, 16, 24, 64 }) {
+        avalanche_strings<std_string>(length);
+        avalanche_strings<ds_string>(length);
+    }
+
+    auto sequential = [](std::size_t i) { return static_cast<std::uint64_t>(i); };
+    auto stride = [](std::size_t i) { return static_cast<std::uint64_t>(i) << 16; };
+    auto high_bits = [](std::size_t i) { return static_cast<std::uint64_t>(i) << 40; };
+    distribution<std_integer>("sequential", sequential);
+    distribution<ds_integer>("sequential", sequential);
+    distribution<std_integer>("stride65536", stride);
+    distribution<ds_integer>("stride65536", stride);
+    distribution<std_integer>("high_bits", high_bits);
+    distribution<ds_integer>("high_bits", high_bits);
+    distribution<std_string>("user:N", numbered);
+    distribution<ds_string>("user:N", numbered);
+
+    crafted<string_hash>("string_hash", "string12", crafted_short_keys(20000));
+    crafted<string_hash>("string_hash", "string40", crafted_keys(40, 24, 20000));
+    crafted<tuple_hash>("tuple_hash", "pair_inverse", crafted_pair_keys(20000));
+
+    std::vector<std::uint64_t> integers(1 << 16);
+    std::mt19937_64 rng(3);
+    for (auto& x : integers) {
+        x = rng();
+    }
+    throughput<std_integer>("uint64", integers, 8);
+    throughput<ds_integer>("uint64", integers, 8);
+    string_throughput<std_string>();
+    string_throughput<ds_string>();
+}
@@ -60,7 +60,7 @@ public:
         vector<vector<int>> freq(nums.size() + 1);
 
         for (int n : nums) {
-            count[n] = 1 + count[n];
+            ++count[n];
         }
         for (const auto& entry : count) {
             freq[entry.second].push_back(entry.first);